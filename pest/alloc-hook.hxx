@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+// replacement global `operator new` / `operator delete` updating the counters of <pest/alloc.hxx>
+//
+// opt-in: include this header in exactly one translation unit of the test or benchmark
+// executable ( replacement allocation functions must not be defined more than once ).
+
+#pragma once
+
+#include <pest/alloc.hxx>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace emptyspace::alloc::detail {
+
+inline void* allocate( std::size_t size ) {
+  if( size == 0 ) { size = 1; }
+  for( ;; ) {
+    if( auto* p = std::malloc( size ) ) {
+      record_alloc( size );
+      return p;
+    }
+    auto const handler = std::get_new_handler();
+    if( handler == nullptr ) { throw std::bad_alloc{}; }
+    handler();
+  }
+}
+
+inline void* allocate( std::size_t size, std::align_val_t const al ) {
+  auto const alignment = std::max( static_cast<std::size_t>( al ), sizeof( void* ) );
+  if( size == 0 ) { size = 1; }
+  for( ;; ) {
+    void* p = nullptr;
+    if( posix_memalign( &p, alignment, size ) == 0 ) {
+      record_alloc( size );
+      return p;
+    }
+    auto const handler = std::get_new_handler();
+    if( handler == nullptr ) { throw std::bad_alloc{}; }
+    handler();
+  }
+}
+
+inline void deallocate( void* const p ) noexcept {
+  if( p == nullptr ) { return; }
+  record_free();
+  std::free( p );
+}
+
+struct install {
+  install() noexcept { _hooked = true; }
+};
+
+static install const _install{};
+
+} // namespace emptyspace::alloc::detail
+
+void* operator new( std::size_t const size ) { return emptyspace::alloc::detail::allocate( size ); }
+
+void* operator new[]( std::size_t const size ) { return emptyspace::alloc::detail::allocate( size ); }
+
+void* operator new( std::size_t const size, std::nothrow_t const& ) noexcept {
+  try {
+    return emptyspace::alloc::detail::allocate( size );
+  } catch( ... ) { //
+    return nullptr;
+  }
+}
+
+void* operator new[]( std::size_t const size, std::nothrow_t const& ) noexcept {
+  try {
+    return emptyspace::alloc::detail::allocate( size );
+  } catch( ... ) { //
+    return nullptr;
+  }
+}
+
+void* operator new( std::size_t const size, std::align_val_t const al ) {
+  return emptyspace::alloc::detail::allocate( size, al );
+}
+
+void* operator new[]( std::size_t const size, std::align_val_t const al ) {
+  return emptyspace::alloc::detail::allocate( size, al );
+}
+
+void* operator new( std::size_t const size, std::align_val_t const al,
+                    std::nothrow_t const& ) noexcept {
+  try {
+    return emptyspace::alloc::detail::allocate( size, al );
+  } catch( ... ) { //
+    return nullptr;
+  }
+}
+
+void* operator new[]( std::size_t const size, std::align_val_t const al,
+                      std::nothrow_t const& ) noexcept {
+  try {
+    return emptyspace::alloc::detail::allocate( size, al );
+  } catch( ... ) { //
+    return nullptr;
+  }
+}
+
+void operator delete( void* const p ) noexcept { emptyspace::alloc::detail::deallocate( p ); }
+
+void operator delete[]( void* const p ) noexcept { emptyspace::alloc::detail::deallocate( p ); }
+
+void operator delete( void* const p, std::size_t ) noexcept {
+  emptyspace::alloc::detail::deallocate( p );
+}
+
+void operator delete[]( void* const p, std::size_t ) noexcept {
+  emptyspace::alloc::detail::deallocate( p );
+}
+
+void operator delete( void* const p, std::nothrow_t const& ) noexcept {
+  emptyspace::alloc::detail::deallocate( p );
+}
+
+void operator delete[]( void* const p, std::nothrow_t const& ) noexcept {
+  emptyspace::alloc::detail::deallocate( p );
+}
+
+void operator delete( void* const p, std::align_val_t ) noexcept {
+  emptyspace::alloc::detail::deallocate( p );
+}
+
+void operator delete[]( void* const p, std::align_val_t ) noexcept {
+  emptyspace::alloc::detail::deallocate( p );
+}
+
+void operator delete( void* const p, std::size_t, std::align_val_t ) noexcept {
+  emptyspace::alloc::detail::deallocate( p );
+}
+
+void operator delete[]( void* const p, std::size_t, std::align_val_t ) noexcept {
+  emptyspace::alloc::detail::deallocate( p );
+}
+
+void operator delete( void* const p, std::align_val_t, std::nothrow_t const& ) noexcept {
+  emptyspace::alloc::detail::deallocate( p );
+}
+
+void operator delete[]( void* const p, std::align_val_t, std::nothrow_t const& ) noexcept {
+  emptyspace::alloc::detail::deallocate( p );
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+// per thread allocation counters
+//
+// the counters are only updated once the replacement global `operator new` / `operator delete`
+// from <pest/alloc-hook.hxx> is linked in, i.e. included in exactly one translation unit of the
+// executable. `pest` and `pnch` read them to check and report allocations of the calling thread.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace emptyspace::alloc {
+
+struct counters {
+  std::uint64_t _allocs{ 0 };
+  std::uint64_t _frees{ 0 };
+  std::uint64_t _bytes{ 0 };
+
+  inline counters operator-( counters const& rhs ) const noexcept {
+    return { _allocs - rhs._allocs, _frees - rhs._frees, _bytes - rhs._bytes };
+  }
+
+  inline counters& operator+=( counters const& rhs ) noexcept {
+    _allocs += rhs._allocs;
+    _frees += rhs._frees;
+    _bytes += rhs._bytes;
+    return *this;
+  }
+};
+
+namespace detail {
+
+// constant initialized, so touching it from inside `operator new` never allocates itself
+inline thread_local counters _local{};
+
+// set during static initialization by <pest/alloc-hook.hxx>
+inline bool _hooked{ false };
+
+} // namespace detail
+
+// true if the replacement `operator new` / `operator delete` are linked in
+inline bool hooked() noexcept { return detail::_hooked; }
+
+// snapshot of the counters of the calling thread. they only ever grow, use differences of two
+// snapshots
+inline counters local() noexcept { return detail::_local; }
+
+inline void record_alloc( std::size_t const bytes ) noexcept {
+  detail::_local._allocs++;
+  detail::_local._bytes += bytes;
+}
+
+inline void record_free() noexcept { detail::_local._frees++; }
+
+} // namespace emptyspace::alloc
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+// @see
+//   - <https://arxiv.org/abs/1805.10941> ( fast random integer generation in an interval )
+//   - <http://www.pcg-random.org/posts/bounded-rands.html>
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace emptyspace {
+
+// uniform integers in `[min, max]` using lemire's multiply-shift. maps the generator output onto the
+// range with one wide multiplication and only needs a modulo ( rejection threshold ) in the rare
+// case the low half of the product falls into the biased zone. `Gen` must produce full range 32 or
+// 64 bit values
+template <typename Int = int>
+class lemire_distribution {
+  using result_type = Int;
+  using range_type = typename std::make_unsigned<result_type>::type;
+
+  result_type _min;
+  range_type _range;
+
+  template <typename Word, typename Wide, typename Gen>
+  inline Word bounded( Gen& gen, Word const s ) const noexcept {
+    auto m = static_cast<Wide>( static_cast<Word>( gen() ) ) * s;
+    auto l = static_cast<Word>( m );
+    if( l < s ) {
+      Word const t = static_cast<Word>( -s ) % s;
+      while( l < t ) {
+        m = static_cast<Wide>( static_cast<Word>( gen() ) ) * s;
+        l = static_cast<Word>( m );
+      }
+    }
+    return static_cast<Word>( m >> ( 8 * sizeof( Word ) ) );
+  }
+
+ public:
+  // `min == max` is allowed and always yields `min`
+  constexpr lemire_distribution( result_type const min, result_type const max ) noexcept
+    : _min{ min },
+      _range{ static_cast<range_type>( static_cast<range_type>( max ) -
+                                       static_cast<range_type>( min ) ) } {
+    assert( min <= max );
+  }
+
+  template <typename Gen>
+  [[nodiscard]] result_type operator()( Gen& gen ) const noexcept {
+    using word = typename Gen::result_type;
+    static_assert( std::is_same_v<word, std::uint64_t> || std::is_same_v<word, std::uint32_t>,
+                   "lemire_distribution needs a 32 or 64 bit generator" );
+    static_assert( sizeof( range_type ) <= sizeof( word ), "generator is narrower than the range" );
+    using wide =
+        std::conditional_t<std::is_same_v<word, std::uint64_t>, unsigned __int128, std::uint64_t>;
+    if( static_cast<word>( _range ) == std::numeric_limits<word>::max() ) {
+      return static_cast<result_type>( static_cast<range_type>( gen() ) +
+                                       static_cast<range_type>( _min ) );
+    }
+    auto const x = bounded<word, wide>( gen, static_cast<word>( _range ) + 1 );
+    return static_cast<result_type>( static_cast<range_type>( x ) + static_cast<range_type>( _min ) );
+  }
+};
+
+} // namespace emptyspace
@@ -2,8 +2,11 @@
 
 #pragma once
 
+#include <pest/alloc.hxx>
+
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
 #include <cmath>
 #include <cstddef>
@@ -11,8 +14,10 @@
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -179,6 +184,32 @@ exception_result throws( F const f ) {
   }
 }
 
+struct test_state;
+
+// checks the allocations of the calling thread from construction to the end of the scope, see
+// `test_state::no_allocations()` and `test_state::at_most_bytes()`
+class allocation_scope {
+  test_state& _state;
+  std::uint64_t const _max_allocs;
+  std::uint64_t const _max_bytes;
+  std::source_location const _where;
+  alloc::counters const _begin;
+
+ public:
+  allocation_scope( test_state& state, std::uint64_t const max_allocs, std::uint64_t const max_bytes,
+                    std::source_location const where ) noexcept
+    : _state{ state },
+      _max_allocs{ max_allocs },
+      _max_bytes{ max_bytes },
+      _where{ where },
+      _begin{ alloc::local() } {}
+
+  allocation_scope( allocation_scope const& ) = delete;
+  allocation_scope& operator=( allocation_scope const& ) = delete;
+
+  inline ~allocation_scope() noexcept;
+};
+
 struct test_state {
   std::ostream& os;
   unsigned _failed{ 0 };
@@ -331,6 +362,45 @@ struct test_state {
     }
   }
 
+  // `allocs` / `bytes` allocated on the calling thread within a scope. skipped if the counting
+  // `operator new` from <pest/alloc-hook.hxx> is not linked in
+  void expect_allocations(
+      alloc::counters const& actual, std::uint64_t const max_allocs, std::uint64_t const max_bytes,
+      std::source_location const where = std::source_location::current() ) noexcept {
+    if( _failed > 0 || ! alloc::hooked() ) {
+      _skipped++;
+      return;
+    }
+    if( actual._allocs <= max_allocs && actual._bytes <= max_bytes ) {
+      _pass++;
+      return;
+    }
+    os << "  failed = " << where << std::endl;
+    if( max_allocs == 0 ) {
+      os << "  assertion = no_allocations" << std::endl;
+      os << "  expected = 0 allocations" << std::endl;
+    } else {
+      os << "  assertion = at_most_bytes" << std::endl;
+      os << "  expected = <= " << max_bytes << " bytes" << std::endl;
+    }
+    os << "  actual = " << actual._allocs << " allocations, " << actual._bytes << " bytes"
+       << std::endl;
+    _failed++;
+  }
+
+  // `auto const scope = expect.no_allocations();` fails if the rest of the scope allocates
+  allocation_scope no_allocations(
+      std::source_location const where = std::source_location::current() ) noexcept {
+    return allocation_scope{ *this, 0, 0, where };
+  }
+
+  // fails if the rest of the scope allocates more than `max_bytes` in total
+  allocation_scope at_most_bytes(
+      std::uint64_t const max_bytes,
+      std::source_location const where = std::source_location::current() ) noexcept {
+    return allocation_scope{ *this, std::numeric_limits<std::uint64_t>::max(), max_bytes, where };
+  }
+
   template <typename T, typename U>
   inline void operator()( T const& lhs, U const& rhs,
                           std::source_location const where = std::source_location::current() ) noexcept {
@@ -348,37 +418,158 @@ struct test_state {
   }
 };
 
+allocation_scope::~allocation_scope() noexcept {
+  _state.expect_allocations( alloc::local() - _begin, _max_allocs, _max_bytes, _where );
+}
+
+// `*` matches any sequence, `?` any single character
+inline bool glob( std::string_view const pattern, std::string_view const text ) noexcept {
+  std::size_t p = 0, t = 0;
+  std::size_t star = std::string_view::npos, mark = 0;
+  while( t < text.size() ) {
+    if( p < pattern.size() && ( pattern[p] == '?' || pattern[p] == text[t] ) ) {
+      p++;
+      t++;
+    } else if( p < pattern.size() && pattern[p] == '*' ) {
+      star = p++;
+      mark = t;
+    } else if( star != std::string_view::npos ) {
+      p = star + 1;
+      t = ++mark;
+    } else {
+      return false;
+    }
+  }
+  while( p < pattern.size() && pattern[p] == '*' ) p++;
+  return p == pattern.size();
+}
+
+struct options {
+  // number of worker threads. with `_jobs > 1` tests are collected first and run afterwards, i.e.
+  // test closures must not capture locals of the suite body by reference
+  unsigned _jobs{ 1 };
+  // glob matched against the test description
+  std::string _filter{ "*" };
+  // only run every `_shards`th selected test starting at `_shard`
+  unsigned _shard{ 0 };
+  unsigned _shards{ 1 };
+
+  // understands `--jobs n`, `--filter glob` and `--shard i/n`. other arguments are ignored
+  static options from_args( int const argc, char const* const* const argv ) {
+    options opts;
+    for( int i = 1; i + 1 < argc; ++i ) {
+      auto const arg = std::string_view{ argv[i] };
+      auto const value = std::string{ argv[i + 1] };
+      if( arg == "--jobs" || arg == "-j" ) {
+        opts._jobs = static_cast<unsigned>( std::stoul( value ) );
+        if( opts._jobs == 0 ) { opts._jobs = std::max( 1u, std::thread::hardware_concurrency() ); }
+      } else if( arg == "--filter" ) {
+        opts._filter = value;
+      } else if( arg == "--shard" ) {
+        auto const slash = value.find( '/' );
+        if( slash == std::string::npos ) { throw std::invalid_argument( "--shard expects i/n" ); }
+        opts._shard = static_cast<unsigned>( std::stoul( value.substr( 0, slash ) ) );
+        opts._shards = static_cast<unsigned>( std::stoul( value.substr( slash + 1 ) ) );
+        if( opts._shards == 0 || opts._shard >= opts._shards ) {
+          throw std::invalid_argument( "--shard expects i/n with i < n" );
+        }
+      } else {
+        continue;
+      }
+      ++i;
+    }
+    return opts;
+  }
+};
+
 struct suite_state {
   std::string _suite;
   std::ostream& os;
+  options _options;
   unsigned _failed{ 0 };
   unsigned _pass{ 0 };
   unsigned _uncaught_exns{ 0 };
   unsigned _tests{ 0 };
   unsigned _skipped{ 0 };
+  unsigned _filtered{ 0 };
+  unsigned _selected{ 0 };
+  std::vector<std::pair<std::string, std::function<void( test_state& )>>> _deferred;
 
-  suite_state( std::string const& suite, std::ostream& out ) : _suite{ suite }, os{ out } {}
+  suite_state( std::string const& suite, std::ostream& out, options const& opts = options{} )
+    : _suite{ suite }, os{ out }, _options{ opts } {}
+
+  bool selected( std::string_view const desc ) noexcept {
+    if( ! glob( _options._filter, desc ) || _selected++ % _options._shards != _options._shard ) {
+      _filtered++;
+      return false;
+    }
+    return true;
+  }
 
   template <typename Closure>
-  void test( std::string_view const desc, Closure clos ) noexcept {
-    os << "[suite <" << _suite << "> | " << desc << "]" << std::endl;
-    _tests++;
-    test_state test{ os };
+  void run( std::ostream& out, std::string_view const desc, Closure& clos,
+            test_state& test ) noexcept {
+    out << "[suite <" << _suite << "> | " << desc << "]" << std::endl;
     try {
       clos( test );
     } catch( std::exception const& e ) {
-      os << "  uncaught exception: what = " << e.what() << std::endl;
-      _uncaught_exns++;
+      out << "  uncaught exception: what = " << e.what() << std::endl;
+      test._uncaught_exns++;
     } catch( ... ) {
-      os << "  uncaught exception =" << std::endl;
-      _uncaught_exns++;
+      out << "  uncaught exception =" << std::endl;
+      test._uncaught_exns++;
     }
+  }
+
+  void accumulate( test_state const& test ) noexcept {
+    _tests++;
     _failed += test._failed;
     _pass += test._pass;
     _uncaught_exns += test._uncaught_exns;
     _skipped += test._skipped;
   }
 
+  template <typename Closure>
+  void test( std::string_view const desc, Closure clos ) noexcept {
+    if( ! selected( desc ) ) { return; }
+    if( _options._jobs > 1 ) {
+      _deferred.emplace_back( std::string{ desc }, std::move( clos ) );
+      return;
+    }
+    test_state test{ os };
+    run( os, desc, clos, test );
+    accumulate( test );
+  }
+
+  // runs the collected tests on a pool of `_jobs` threads. every test writes into its own buffer
+  // and the buffers are emitted in declaration order to keep the log deterministic
+  void run_deferred() {
+    auto const n = _deferred.size();
+    if( n == 0 ) { return; }
+    std::vector<std::ostringstream> outs( n );
+    std::vector<test_state> states;
+    states.reserve( n );
+    for( auto& out : outs ) states.push_back( test_state{ out } );
+    std::atomic<std::size_t> next{ 0 };
+    auto worker = [&]() {
+      for( auto i = next++; i < n; i = next++ ) {
+        run( outs[i], _deferred[i].first, _deferred[i].second, states[i] );
+      }
+    };
+    std::vector<std::thread> pool;
+    for( std::size_t k = 1; k < std::min<std::size_t>( _options._jobs, n ); ++k ) {
+      pool.emplace_back( worker );
+    }
+    worker();
+    for( auto& t : pool ) t.join();
+    for( std::size_t i = 0; i < n; ++i ) {
+      os << outs[i].str();
+      accumulate( states[i] );
+    }
+    os.flush();
+    _deferred.clear();
+  }
+
   template <typename Closure>
   inline void operator()( std::string_view const desc, Closure clos ) noexcept {
     test( desc, clos );
@@ -392,16 +583,18 @@ struct suite {
   template <typename T>
   suite( std::string_view const name, T&& t ) : _name{ name }, _behaviour{ std::move( t ) } {}
 
-  void operator()( std::ostream& os ) noexcept {
-    suite_state st{ _name, os };
+  void operator()( std::ostream& os, options const& opts = options{} ) noexcept {
+    suite_state st{ _name, os, opts };
     try {
       _behaviour( st );
+      st.run_deferred();
       os << "[suite <" << _name << "> | summary]" << std::endl;
       os << "  total assertions failed = " << st._failed << std::endl;
       os << "  total assertions pass = " << st._pass << std::endl;
       os << "  total assertions skipped = " << st._skipped << std::endl;
       os << "  total uncaught exceptions = " << st._uncaught_exns << std::endl;
       os << "  total tests = " << st._tests << std::endl;
+      if( st._filtered > 0 ) { os << "  total tests filtered = " << st._filtered << std::endl; }
     } catch( ... ) { os << "*** suite uncaught exception ***" << std::endl; }
   }
 };
@@ -2,18 +2,35 @@
 
 #pragma once
 
+#include <pest/alloc.hxx>
+
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
+#include <charconv>
 #include <chrono>
+#include <cctype>
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <istream>
+#include <limits>
+#include <map>
 #include <memory>
 #include <numeric>
 #include <ostream>
 #include <ratio>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -22,23 +39,29 @@
 #  include <pthread_np.h>
 #  include <sys/cpuset.h>
 #  include <sys/resource.h>
+#  include <sys/sysctl.h>
 #  include <sys/time.h>
 #  include <sys/types.h>
 #elif defined( __NetBSD__ )
 #  include <pthread.h>
 #  include <sched.h>
 #  include <sys/resource.h>
+#  include <sys/sysctl.h>
 #  include <sys/time.h>
 #  include <sys/types.h>
 #elif defined( __linux__ )
 #  if ! defined( _GNU_SOURCE )
 #    define _GNU_SOURCE
 #  endif
+#  include <linux/perf_event.h>
 #  include <pthread.h>
 #  include <sched.h>
+#  include <sys/ioctl.h>
 #  include <sys/resource.h>
+#  include <sys/syscall.h>
 #  include <sys/time.h>
 #  include <sys/types.h>
+#  include <unistd.h>
 #else
 #  error unkown platform: need posix like environment ( currently only freebsd and linux are supported )
 #endif
@@ -47,6 +70,11 @@
 //   - <github.com/cameron314/microbench>
 //   - <github.com/martinus/nanobench>
 
+#if defined( __x86_64__ ) || defined( __i386__ )
+#  include <cpuid.h>
+#  include <x86intrin.h>
+#endif
+
 #ifdef __clang__
 #  pragma clang diagnostic push
 #  pragma clang diagnostic ignored "-Wpadded"
@@ -209,6 +237,650 @@ struct perfc {
 #  error unknown platform: do not know how to querying performance counters
 #endif
 
+#if defined( __linux__ )
+// hardware performance counters using `perf_event_open(2)`
+//   - all events are opened as one group so they are scheduled onto the pmu together
+//   - if the kernel refuses ( `perf_event_paranoid`, seccomp in containers, no pmu in vms ) the
+//     group stays closed and nothing is reported, i.e. we fall back to plain `getrusage`
+//   - copies share the event list and the collected samples but not the file descriptors
+struct hwc {
+  struct event {
+    std::string _name;
+    std::uint32_t _type;
+    std::uint64_t _config;
+    int _fd{ -1 };
+    bool _counted{ false };
+  };
+
+  std::vector<event> _events;
+  bool _enabled{ true };
+  int _leader{ -1 };
+  // read buffer for `PERF_FORMAT_GROUP`: { nr, time_enabled, time_running, values[nr] }
+  std::vector<std::uint64_t> _begin;
+  std::vector<std::uint64_t> _end;
+  // per sample deltas for every event ( row major, scaled for multiplexing )
+  std::vector<double> _deltas;
+  std::size_t _samples{ 0 };
+
+  static constexpr std::uint64_t cache_miss( std::uint64_t const cache ) noexcept {
+    return cache | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+  }
+
+  explicit hwc() {
+    _events.push_back( { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES } );
+    _events.push_back( { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS } );
+    _events.push_back( { "l1d misses", PERF_TYPE_HW_CACHE, cache_miss( PERF_COUNT_HW_CACHE_L1D ) } );
+    _events.push_back( { "llc misses", PERF_TYPE_HW_CACHE, cache_miss( PERF_COUNT_HW_CACHE_LL ) } );
+    _events.push_back( { "branch misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES } );
+  }
+
+  hwc( hwc const& other )
+    : _events{ other._events },
+      _enabled{ other._enabled },
+      _deltas{ other._deltas },
+      _samples{ other._samples } {
+    for( auto& e : _events ) e._fd = -1;
+  }
+
+  hwc& operator=( hwc const& other ) {
+    if( this != &other ) {
+      close();
+      _events = other._events;
+      for( auto& e : _events ) e._fd = -1;
+      _enabled = other._enabled;
+      _deltas = other._deltas;
+      _samples = other._samples;
+    }
+    return *this;
+  }
+
+  ~hwc() noexcept { close(); }
+
+  inline bool valid() const noexcept { return _leader >= 0; }
+
+  inline std::size_t samples() const noexcept { return _samples; }
+
+  void enable( bool const enabled ) noexcept {
+    close();
+    _enabled = enabled;
+  }
+
+  // adds a raw, model specific event ( `PERF_TYPE_RAW` ), e.g. `0x01c2` for uops retired
+  void add( std::string_view const name, std::uint64_t const raw ) {
+    close();
+    _events.push_back( { std::string{ name }, PERF_TYPE_RAW, raw } );
+  }
+
+  void close() noexcept {
+    for( auto& e : _events ) {
+      if( e._fd >= 0 ) { ::close( e._fd ); }
+      e._fd = -1;
+    }
+    _leader = -1;
+  }
+
+  void open() noexcept {
+    if( valid() || ! _enabled ) { return; }
+    for( auto& e : _events ) e._counted = false;
+    std::size_t n = 0;
+    for( auto& e : _events ) {
+      perf_event_attr attr;
+      std::memset( &attr, 0, sizeof( attr ) );
+      attr.size = sizeof( attr );
+      attr.type = e._type;
+      attr.config = e._config;
+      attr.disabled = _leader < 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format =
+          PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      auto const fd = static_cast<int>( syscall( SYS_perf_event_open, &attr, 0, -1, _leader, 0 ) );
+      // unsupported events are skipped, the remaining ones are still useful
+      e._counted = fd >= 0;
+      if( fd < 0 ) { continue; }
+      e._fd = fd;
+      if( _leader < 0 ) { _leader = fd; }
+      n++;
+    }
+    if( ! valid() ) { return; }
+    _begin.assign( 3 + n, 0 );
+    _end.assign( 3 + n, 0 );
+    if( ioctl( _leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP ) != 0 ||
+        ioctl( _leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP ) != 0 ) {
+      close();
+    }
+  }
+
+  void clear() noexcept {
+    _deltas.clear();
+    _samples = 0;
+  }
+
+  inline bool read( std::vector<std::uint64_t>& buf ) noexcept {
+    auto const sz = static_cast<ssize_t>( buf.size() * sizeof( std::uint64_t ) );
+    return ::read( _leader, buf.data(), static_cast<std::size_t>( sz ) ) == sz;
+  }
+
+  void sample_begin() noexcept {
+    if( valid() && ! read( _begin ) ) { close(); }
+  }
+
+  void sample_end() noexcept {
+    if( ! valid() ) { return; }
+    if( ! read( _end ) ) {
+      close();
+      return;
+    }
+    // scale for multiplexing in case the group did not fit onto the pmu the whole time. a group
+    // that was never scheduled measured nothing, such samples are dropped instead of reported as 0
+    auto const enabled = static_cast<double>( _end[1] - _begin[1] );
+    auto const running = static_cast<double>( _end[2] - _begin[2] );
+    if( running <= 0 ) { return; }
+    auto const scale = enabled / running;
+    std::size_t k = 3;
+    for( auto const& e : _events ) {
+      if( e._fd < 0 ) {
+        _deltas.push_back( .0 );
+        continue;
+      }
+      _deltas.push_back( static_cast<double>( _end[k] - _begin[k] ) * scale );
+      k++;
+    }
+    _samples++;
+  }
+
+  // index of the event named `name` or `_events.size()` if not counted
+  std::size_t find( std::string_view const name ) const noexcept {
+    for( std::size_t i = 0; i < _events.size(); ++i ) {
+      if( _events[i]._name == name && _events[i]._counted ) { return i; }
+    }
+    return _events.size();
+  }
+
+  double total( std::size_t const which ) const noexcept {
+    double sum = .0;
+    for( std::size_t i = 0; i < _samples; ++i ) { sum += _deltas[i * _events.size() + which]; }
+    return sum;
+  }
+
+  void report_to( std::ostream& os, std::string_view const pre, double const ops ) noexcept {
+    if( _samples == 0 ) { return; }
+    auto const sep = pre == "" ? "  hwc" : "  hwc/";
+    auto const n = static_cast<double>( _samples ) * ops;
+    for( std::size_t i = 0; i < _events.size(); ++i ) {
+      if( ! _events[i]._counted ) { continue; }
+      os << sep << pre << "/" << _events[i]._name << " = " << ( total( i ) / n ) << std::endl;
+    }
+    auto const cycles = find( "cycles" );
+    auto const instructions = find( "instructions" );
+    if( cycles < _events.size() && instructions < _events.size() && total( cycles ) > 0 ) {
+      os << sep << pre << "/ipc = " << ( total( instructions ) / total( cycles ) ) << std::endl;
+    }
+  }
+
+  void json_to( std::ostream& os ) const noexcept;
+};
+#else
+// hardware performance counters are only supported on linux for now
+struct hwc {
+  inline bool valid() const noexcept { return false; }
+  inline std::size_t samples() const noexcept { return 0; }
+  void enable( bool const ) noexcept {}
+  void add( std::string_view const, std::uint64_t const ) {}
+  void open() noexcept {}
+  void close() noexcept {}
+  void clear() noexcept {}
+  void sample_begin() noexcept {}
+  void sample_end() noexcept {}
+  void report_to( std::ostream&, std::string_view const, double const ) noexcept {}
+  void json_to( std::ostream& os ) const noexcept { os << "{}"; }
+};
+#endif
+
+// allocations of the calling thread while sampling. only counted if the replacement `operator new`
+// from <pest/alloc-hook.hxx> is linked in
+struct allocations {
+  alloc::counters _begin{};
+  alloc::counters _total{};
+  std::size_t _samples{ 0 };
+
+  void clear() noexcept {
+    _total = alloc::counters{};
+    _samples = 0;
+  }
+
+  inline void sample_begin() noexcept { _begin = alloc::local(); }
+
+  inline void sample_end() noexcept {
+    _total += alloc::local() - _begin;
+    _samples++;
+  }
+
+  void report_to( std::ostream& os, std::string_view const pre, double const ops ) const noexcept {
+    if( ! alloc::hooked() || _samples == 0 ) { return; }
+    auto const sep = pre == "" ? "  alloc" : "  alloc/";
+    auto const n = static_cast<double>( _samples ) * ops;
+    os << sep << pre << "/allocs = " << ( static_cast<double>( _total._allocs ) / n ) << std::endl;
+    os << sep << pre << "/bytes = " << ( static_cast<double>( _total._bytes ) / n ) << std::endl;
+    os << sep << pre << "/frees = " << ( static_cast<double>( _total._frees ) / n ) << std::endl;
+  }
+
+  void json_to( std::ostream& os ) const noexcept {
+    if( ! alloc::hooked() ) {
+      os << "{}";
+      return;
+    }
+    os << "{\"samples\":" << _samples << ",\"allocs\":" << _total._allocs
+       << ",\"bytes\":" << _total._bytes << ",\"frees\":" << _total._frees << "}";
+  }
+};
+
+inline void spin_pause() noexcept {
+#if defined( __x86_64__ ) || defined( __i386__ )
+  __builtin_ia32_pause();
+#elif defined( __aarch64__ )
+  asm volatile( "yield" );
+#endif
+}
+
+// all threads leave `wait()` together. spins instead of sleeping so the release is not delayed by
+// the scheduler, but yields once it spun for a while in case threads outnumber cpus
+struct spin_barrier {
+  std::size_t const _n;
+  std::atomic<std::size_t> _waiting{ 0 };
+  std::atomic<std::size_t> _generation{ 0 };
+
+  explicit spin_barrier( std::size_t const n ) noexcept : _n{ n } {}
+
+  void wait() noexcept {
+    auto const generation = _generation.load( std::memory_order_acquire );
+    if( _waiting.fetch_add( 1, std::memory_order_acq_rel ) + 1 == _n ) {
+      _waiting.store( 0, std::memory_order_relaxed );
+      _generation.fetch_add( 1, std::memory_order_release );
+      return;
+    }
+    for( unsigned spins = 0; _generation.load( std::memory_order_acquire ) == generation; ++spins ) {
+      if( spins < 4096 ) {
+        spin_pause();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+};
+
+// parses the kernel's list format, e.g. `0-3,8-11\n`. empty lists ( memory only nodes ) yield no
+// entries
+inline std::vector<int> parse_cpulist( std::string_view const list ) {
+  std::vector<int> xs;
+  std::size_t pos = 0;
+  while( pos < list.size() ) {
+    auto comma = list.find( ',', pos );
+    if( comma == std::string_view::npos ) { comma = list.size(); }
+    auto const range = list.substr( pos, comma - pos );
+    pos = comma + 1;
+    auto const first = std::find_if( range.begin(), range.end(),
+                                     []( char const c ) { return std::isdigit( c ) != 0; } );
+    if( first == range.end() ) { continue; }
+    auto const str = std::string{ first, range.end() };
+    auto const dash = str.find( '-' );
+    auto const lo = std::atoi( str.c_str() );
+    auto const hi = dash == std::string::npos ? lo : std::atoi( str.c_str() + dash + 1 );
+    for( int x = lo; x <= hi; ++x ) xs.push_back( x );
+  }
+  return xs;
+}
+
+// cpus the calling thread may run on ( cgroups / `taskset` )
+inline std::vector<int> allowed_cpus() {
+  std::vector<int> cpus;
+#if defined( __linux__ )
+  cpu_set_t set;
+  CPU_ZERO( &set );
+  if( sched_getaffinity( 0, sizeof( set ), &set ) == 0 ) {
+    for( int cpu = 0; cpu < CPU_SETSIZE; ++cpu ) {
+      if( CPU_ISSET( cpu, &set ) ) cpus.push_back( cpu );
+    }
+  }
+#endif
+  if( cpus.empty() ) {
+    cpus.resize( std::max( 1u, std::thread::hardware_concurrency() ) );
+    std::iota( cpus.begin(), cpus.end(), 0 );
+  }
+  return cpus;
+}
+
+// allowed cpus grouped by numa node. falls back to a single node holding all allowed cpus if the
+// topology is unknown
+inline std::vector<std::vector<int>> numa_nodes() {
+  auto const allowed = allowed_cpus();
+  std::vector<std::vector<int>> nodes;
+#if defined( __linux__ )
+  auto const read = []( std::string const& path ) {
+    std::ifstream in{ path };
+    std::string list;
+    std::getline( in, list );
+    return list;
+  };
+  // node ids may be sparse
+  for( auto const node : parse_cpulist( read( "/sys/devices/system/node/online" ) ) ) {
+    std::vector<int> cpus;
+    auto const path = "/sys/devices/system/node/node" + std::to_string( node ) + "/cpulist";
+    for( auto const cpu : parse_cpulist( read( path ) ) ) {
+      if( std::binary_search( allowed.begin(), allowed.end(), cpu ) ) cpus.push_back( cpu );
+    }
+    if( ! cpus.empty() ) nodes.push_back( std::move( cpus ) );
+  }
+#endif
+  if( nodes.empty() ) { nodes.push_back( allowed ); }
+  return nodes;
+}
+
+// cheap timestamps for timing single calls
+//   - `rdtsc` if the cpu has an invariant tsc, calibrated once against `steady_clock`
+//   - `clock_gettime( CLOCK_MONOTONIC )` otherwise
+struct tsc {
+  bool _rdtsc;
+  double _ns_per_tick;
+
+  static bool invariant() noexcept {
+#if defined( __x86_64__ ) || defined( __i386__ )
+    unsigned eax, ebx, ecx, edx;
+    if( __get_cpuid( 0x80000007, &eax, &ebx, &ecx, &edx ) == 0 ) { return false; }
+    return ( edx & ( 1u << 8 ) ) != 0;
+#else
+    return false;
+#endif
+  }
+
+  explicit tsc() noexcept : _rdtsc{ invariant() }, _ns_per_tick{ 1.0 } {
+    if( ! _rdtsc ) { return; }
+    auto const begin = std::chrono::steady_clock::now();
+    auto const t0 = ticks();
+    auto end = std::chrono::steady_clock::now();
+    while( end - begin < std::chrono::milliseconds{ 10 } ) { end = std::chrono::steady_clock::now(); }
+    auto const t1 = ticks();
+    auto const ns = std::chrono::duration<double, std::nano>( end - begin ).count();
+    if( t1 > t0 ) {
+      _ns_per_tick = ns / static_cast<double>( t1 - t0 );
+    } else {
+      _rdtsc = false;
+    }
+  }
+
+  static tsc const& instance() noexcept {
+    static tsc const t{};
+    return t;
+  }
+
+  inline std::uint64_t ticks() const noexcept {
+#if defined( __x86_64__ ) || defined( __i386__ )
+    if( _rdtsc ) {
+      _mm_lfence();
+      auto const t = __rdtsc();
+      _mm_lfence();
+      return t;
+    }
+#endif
+    timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return static_cast<std::uint64_t>( ts.tv_sec ) * 1'000'000'000ull +
+        static_cast<std::uint64_t>( ts.tv_nsec );
+  }
+
+  inline double ns_per_tick() const noexcept { return _ns_per_tick; }
+};
+
+//--json-helpers---------------------------------------------------------------
+
+inline void json_string( std::ostream& os, std::string_view const s ) noexcept {
+  os << '"';
+  for( auto const c : s ) {
+    switch( c ) {
+      case '"': os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n"; break;
+      case '\t': os << "\\t"; break;
+      default:
+        if( static_cast<unsigned char>( c ) < 0x20 ) {
+          char buf[8];
+          std::snprintf( buf, sizeof( buf ), "\\u%04x", c );
+          os << buf;
+        } else {
+          os << c;
+        }
+    }
+  }
+  os << '"';
+}
+
+// round trip precision, `null` for nan and inf which are not valid json
+inline void json_number( std::ostream& os, double const x ) noexcept {
+  if( ! std::isfinite( x ) ) {
+    os << "null";
+    return;
+  }
+  auto const precision = os.precision( std::numeric_limits<double>::max_digits10 );
+  os << x;
+  os.precision( precision );
+}
+
+inline void json_to( std::ostream& os, rusage const& ru ) noexcept {
+  os << "{\"max resident set size\":" << ru.ru_maxrss << ",\"minor page faults\":" << ru.ru_minflt
+     << ",\"major page faults\":" << ru.ru_majflt << "}";
+}
+
+#if defined( __linux__ )
+inline void hwc::json_to( std::ostream& os ) const noexcept {
+  os << "{\"samples\":" << _samples;
+  for( std::size_t i = 0; i < _events.size(); ++i ) {
+    if( ! _events[i]._counted || _samples == 0 ) { continue; }
+    os << ",";
+    json_string( os, _events[i]._name );
+    os << ":";
+    json_number( os, total( i ) );
+  }
+  os << "}";
+}
+#endif
+
+// metadata identifying the machine a result was measured on
+struct environment {
+  std::string _cpu{ "unknown" };
+  std::string _governor{ "unknown" };
+  std::string _compiler{ "unknown" };
+
+  explicit environment() {
+#if defined( __VERSION__ )
+#  if defined( __clang__ )
+    _compiler = "clang " __VERSION__;
+#  else
+    _compiler = "gcc " __VERSION__;
+#  endif
+#endif
+#if defined( __linux__ )
+    std::ifstream cpuinfo{ "/proc/cpuinfo" };
+    for( std::string line; std::getline( cpuinfo, line ); ) {
+      if( line.rfind( "model name", 0 ) != 0 ) { continue; }
+      auto const colon = line.find( ':' );
+      if( colon != std::string::npos && colon + 2 <= line.size() ) { _cpu = line.substr( colon + 2 ); }
+      break;
+    }
+    std::ifstream governor{ "/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor" };
+    std::getline( governor, _governor );
+    if( _governor.empty() ) { _governor = "unknown"; }
+#else
+    char model[256];
+    std::size_t len = sizeof( model );
+    if( sysctlbyname( "hw.model", model, &len, nullptr, 0 ) == 0 && len > 0 ) {
+      _cpu.assign( model, strnlen( model, len ) );
+    }
+#endif
+  }
+
+  static environment const& instance() {
+    static environment const env{};
+    return env;
+  }
+
+  void json_to( std::ostream& os ) const noexcept {
+    os << "{\"cpu\":";
+    json_string( os, _cpu );
+    os << ",\"governor\":";
+    json_string( os, _governor );
+    os << ",\"compiler\":";
+    json_string( os, _compiler );
+    os << "}";
+  }
+};
+
+// just enough json to read back the lines written by `config::json_to`
+struct json_reader {
+  std::string_view _s;
+  std::size_t _i{ 0 };
+
+  explicit json_reader( std::string_view const s ) noexcept : _s{ s } {}
+
+  void ws() noexcept {
+    while( _i < _s.size() && std::isspace( static_cast<unsigned char>( _s[_i] ) ) ) _i++;
+  }
+
+  bool eat( char const c ) noexcept {
+    ws();
+    if( _i < _s.size() && _s[_i] == c ) {
+      _i++;
+      return true;
+    }
+    return false;
+  }
+
+  bool peek( char const c ) noexcept {
+    ws();
+    return _i < _s.size() && _s[_i] == c;
+  }
+
+  bool string( std::string& out ) {
+    if( ! eat( '"' ) ) { return false; }
+    out.clear();
+    while( _i < _s.size() ) {
+      auto const c = _s[_i++];
+      if( c == '"' ) { return true; }
+      if( c != '\\' ) {
+        out.push_back( c );
+        continue;
+      }
+      if( _i >= _s.size() ) { return false; }
+      switch( auto const e = _s[_i++]; e ) {
+        case 'n': out.push_back( '\n' ); break;
+        case 't': out.push_back( '\t' ); break;
+        case 'u': {
+          if( _i + 4 > _s.size() ) { return false; }
+          unsigned code = 0;
+          auto const* const first = _s.data() + _i;
+          auto const [last, ec] = std::from_chars( first, first + 4, code, 16 );
+          if( ec != std::errc{} || last != first + 4 ) { return false; }
+          out.push_back( static_cast<char>( code ) );
+          _i += 4;
+          break;
+        }
+        default: out.push_back( e ); break;
+      }
+    }
+    return false;
+  }
+
+  // `null` is read as nan
+  bool number( double& out ) noexcept {
+    ws();
+    if( _s.substr( _i, 4 ) == "null" ) {
+      _i += 4;
+      out = std::numeric_limits<double>::quiet_NaN();
+      return true;
+    }
+    auto const begin = _i;
+    while( _i < _s.size() && _s[_i] != '\0' && std::strchr( "+-.0123456789eE", _s[_i] ) != nullptr ) {
+      _i++;
+    }
+    if( begin == _i ) { return false; }
+    out = std::strtod( std::string{ _s.substr( begin, _i - begin ) }.c_str(), nullptr );
+    return true;
+  }
+
+  bool skip() {
+    ws();
+    if( _i >= _s.size() ) { return false; }
+    std::string tmp;
+    double x;
+    switch( _s[_i] ) {
+      case '"': return string( tmp );
+      case '{':
+      case '[': {
+        auto const close = _s[_i] == '{' ? '}' : ']';
+        _i++;
+        if( eat( close ) ) { return true; }
+        do {
+          if( close == '}' && ( ! string( tmp ) || ! eat( ':' ) ) ) { return false; }
+          if( ! skip() ) { return false; }
+        } while( eat( ',' ) );
+        return eat( close );
+      }
+      case 't': _i += 4; return true;
+      case 'f': _i += 5; return true;
+      default: return number( x );
+    }
+  }
+};
+
+// two sided p-value of the mann-whitney u test using the normal approximation with tie correction
+inline double mann_whitney( std::vector<double> const& a, std::vector<double> const& b ) {
+  auto const n1 = static_cast<double>( a.size() );
+  auto const n2 = static_cast<double>( b.size() );
+  if( a.empty() || b.empty() ) { return 1.0; }
+  std::vector<std::pair<double, bool>> all;
+  all.reserve( a.size() + b.size() );
+  for( auto x : a ) all.emplace_back( x, true );
+  for( auto x : b ) all.emplace_back( x, false );
+  std::sort( all.begin(), all.end() );
+  auto const n = static_cast<double>( all.size() );
+  double r1 = .0;
+  double ties = .0;
+  for( std::size_t i = 0; i < all.size(); ) {
+    auto j = i;
+    while( j < all.size() && all[j].first == all[i].first ) j++;
+    // average rank ( 1 based ) of the tied group
+    auto const rank = static_cast<double>( i + j + 1 ) * 0.5;
+    auto const t = static_cast<double>( j - i );
+    ties += t * t * t - t;
+    for( auto k = i; k < j; ++k ) {
+      if( all[k].second ) r1 += rank;
+    }
+    i = j;
+  }
+  auto const u = r1 - n1 * ( n1 + 1 ) * 0.5;
+  auto const mu = n1 * n2 * 0.5;
+  auto const sigma = std::sqrt( n1 * n2 / 12.0 * ( ( n + 1 ) - ties / ( n * ( n - 1 ) ) ) );
+  if( sigma == .0 ) { return 1.0; }
+  // continuity correction
+  auto const z = std::max( .0, std::abs( u - mu ) - 0.5 ) / sigma;
+  return std::erfc( z / std::sqrt( 2.0 ) );
+}
+
+inline double median( std::vector<double> v ) {
+  if( v.empty() ) { return .0; }
+  std::sort( v.begin(), v.end() );
+  auto const n = v.size();
+  return ( n & 1 ) == 0 ? ( v[n / 2 - 1] + v[n / 2] ) * 0.5 : v[n / 2];
+}
+
+// per iteration samples as used by `stats_t`
+inline std::vector<double> per_op( std::vector<double> const& results, std::uint64_t const inner,
+                                   double const offset ) {
+  std::vector<double> v;
+  v.reserve( results.size() );
+  for( auto x : results ) v.push_back( x / static_cast<double>( inner ) - offset );
+  return v;
+}
+
 // @see https://github.com/facebook/folly/blob/master/folly/Benchmark.h
 
 template <typename T>
@@ -249,6 +921,11 @@ auto doNotOptimizeAway( const T& datum ) ->
   asm volatile( "" ::"m"( datum ) : "memory" );
 }
 
+// loop body used to measure the loop overhead. the compiler barrier keeps the loop alive
+struct noop {
+  inline void operator()() const noexcept { asm volatile( "" ); }
+};
+
 struct stats_t {
  private:
   double _min;
@@ -256,6 +933,7 @@ struct stats_t {
   double _q[3];
   double _avg;
   double _variance;
+  std::size_t _count;
 
  public:
   stats_t( std::vector<double> const& results, std::uint64_t const inner_loop_cnt,
@@ -264,6 +942,7 @@ struct stats_t {
     std::sort( _results.begin(), _results.end() );
     auto count = _results.size();
     auto scale = static_cast<double>( inner_loop_cnt );
+    _count = count;
 
     for( decltype( count ) i = 0; i < count; ++i ) {
       _results[i] /= scale;
@@ -333,6 +1012,14 @@ struct stats_t {
 
   inline double stddev() const noexcept { return std::sqrt( _variance ); }
 
+  inline std::size_t count() const noexcept { return _count; }
+
+  // relative standard error of the mean
+  inline double rse() const noexcept {
+    if( _count < 2 || _avg == .0 ) { return .0; }
+    return stddev() / std::sqrt( static_cast<double>( _count ) ) / std::abs( _avg );
+  }
+
   inline double median() const noexcept { return _q[1]; }
 
   inline double q1() const noexcept { return _q[0]; }
@@ -345,6 +1032,26 @@ struct stats_t {
     assert( which < 4 && which > 0 );
     return _q[which - 1];
   }
+
+  void json_to( std::ostream& os ) const noexcept {
+    os << "{\"min\":";
+    json_number( os, _min );
+    os << ",\"max\":";
+    json_number( os, _max );
+    os << ",\"average\":";
+    json_number( os, _avg );
+    os << ",\"stddev\":";
+    json_number( os, stddev() );
+    os << ",\"q1\":";
+    json_number( os, _q[0] );
+    os << ",\"median\":";
+    json_number( os, _q[1] );
+    os << ",\"q3\":";
+    json_number( os, _q[2] );
+    os << ",\"rse\":";
+    json_number( os, rse() );
+    os << "}";
+  }
 };
 } // namespace detail
 
@@ -355,6 +1062,8 @@ void doNotOptimizeAway( Args&&... args ) {
 
 struct config {
   detail::perfc _perfc;
+  detail::hwc _hwc;
+  detail::allocations _allocs;
   std::uint64_t _inner_loop_cnt{ 100'000 };
   std::uint32_t _outer_loop_cnt{ 23 };
   std::string _name;
@@ -363,6 +1072,18 @@ struct config {
   double _offset{ .0 };
   std::vector<double> _results;
 
+  // settings for `calibrate()`
+  std::chrono::nanoseconds _target{ std::chrono::milliseconds{ 10 } };
+  std::chrono::nanoseconds _warmup{ std::chrono::milliseconds{ 100 } };
+  std::chrono::nanoseconds _budget{ std::chrono::seconds{ 5 } };
+  double _max_rse{ 0.01 };
+  std::uint32_t _min_samples{ 5 };
+  bool _calibrated{ false };
+  bool _target_reached{ true };
+
+  // upper bound of the inner loop count `calibrate()` tries to reach `_target`
+  static constexpr std::uint64_t MAX_INNER = std::uint64_t{ 1 } << 40;
+
   void reset() noexcept {
     _cached_stats.reset( nullptr );
     _offset = .0;
@@ -398,20 +1119,160 @@ struct config {
     return *this;
   }
 
+  template <typename TFunc>
+  inline double sample( std::uint64_t const inner_loop_cnt, TFunc&& func ) noexcept {
+    _allocs.sample_begin();
+    _hwc.sample_begin();
+    auto start = detail::perfc::now();
+    for( std::uint64_t j = 0; j < inner_loop_cnt; ++j ) { func(); }
+    auto end = detail::perfc::now();
+    _hwc.sample_end();
+    _allocs.sample_end();
+    return std::chrono::duration<double, std::nano>( end - start ).count();
+  }
+
   template <typename TFunc>
   config& run( std::string_view const name, TFunc&& func ) noexcept {
     reset();
     _results.clear();
     _name = name;
+    _calibrated = false;
+    _hwc.open();
+    _hwc.clear();
+    _allocs.clear();
     _perfc.begin();
     for( std::uint32_t i = 0; i < _outer_loop_cnt; ++i ) {
-      auto start = detail::perfc::now();
-      for( std::uint64_t j = 0; j < _inner_loop_cnt; ++j ) { func(); }
-      auto end = detail::perfc::now();
-      auto delta = std::chrono::duration<double, std::nano>( end - start ).count();
-      _results.push_back( delta );
+      _results.push_back( sample( _inner_loop_cnt, func ) );
+    }
+    _perfc.end();
+    return *this;
+  }
+
+  // target duration of a single sample. raised to at least 1000x the clock resolution
+  config& target( std::chrono::nanoseconds const target ) noexcept {
+    _target = target;
+    return *this;
+  }
+
+  config& warmup( std::chrono::nanoseconds const warmup ) noexcept {
+    _warmup = warmup;
+    return *this;
+  }
+
+  // total time budget of `calibrate()`, shared by the search for the inner loop count and the
+  // samples. sampling stops early once `rse < max_rse`, but takes at least `min_samples()` samples
+  // even if the search used up the budget
+  config& budget( std::chrono::nanoseconds const budget, double const max_rse = 0.01 ) noexcept {
+    _budget = budget;
+    _max_rse = max_rse;
+    return *this;
+  }
+
+  // number of samples `calibrate()` takes before checking the stop rule
+  config& min_samples( std::uint32_t const min_samples ) noexcept {
+    _min_samples = std::max<std::uint32_t>( 2, min_samples );
+    return *this;
+  }
+
+  // smallest non-zero difference between two consecutive `perfc::now()` calls
+  static double resolution() noexcept {
+    double res = std::numeric_limits<double>::max();
+    for( int i = 0; i < 64; ++i ) {
+      auto const t0 = detail::perfc::now();
+      auto t1 = detail::perfc::now();
+      while( t1 == t0 ) { t1 = detail::perfc::now(); }
+      res = std::min( res, std::chrono::duration<double, std::nano>( t1 - t0 ).count() );
+    }
+    return res;
+  }
+
+  // cost of the `perfc::now()` fences and the clock itself for one sample
+  static double timer_overhead() noexcept {
+    double overhead = std::numeric_limits<double>::max();
+    for( int i = 0; i < 64; ++i ) {
+      auto const t0 = detail::perfc::now();
+      auto const t1 = detail::perfc::now();
+      overhead = std::min( overhead, std::chrono::duration<double, std::nano>( t1 - t0 ).count() );
+    }
+    return overhead;
+  }
+
+  // calibrated alternative to `run()`:
+  //   - warms up `func` for `_warmup`
+  //   - measures timer and empty loop overhead and uses it as `offset()`
+  //   - picks the inner loop count so a sample takes about `_target`
+  //   - samples until the relative standard error drops below `_max_rse` or `_budget` ( shared
+  //     with the search ) is exhausted
+  template <typename TFunc>
+  config& calibrate( std::string_view const name, TFunc&& func ) noexcept {
+    using clock = std::chrono::steady_clock;
+    reset();
+    _results.clear();
+    _name = name;
+    _calibrated = true;
+
+    auto const target = std::max( static_cast<double>( _target.count() ), 1000.0 * resolution() );
+    auto const timer = timer_overhead();
+
+    // warmup and find the inner loop count reaching `target`. closures the compiler folds to
+    // constant time never get there, so the search is bounded by `MAX_INNER` and `_budget`
+    std::uint64_t n = 1;
+    double delta = .0;
+    auto const warmup_end = clock::now() + _warmup;
+    // one budget for the search and the samples
+    auto const deadline = clock::now() + _budget;
+    _target_reached = true;
+    for( ;; ) {
+      delta = sample( n, func ) - timer;
+      if( delta >= target && clock::now() >= warmup_end ) { break; }
+      if( delta >= target ) { continue; }
+      if( n >= MAX_INNER || clock::now() >= deadline ) {
+        _target_reached = false;
+        break;
+      }
+      n *= 2;
+    }
+    // without reaching the target `delta` says nothing about the cost of `func`, keep `n`
+    if( _target_reached ) {
+      auto const scaled = static_cast<double>( n ) * target / std::max( delta, 1.0 );
+      n = std::max<std::uint64_t>( 1, static_cast<std::uint64_t>( scaled ) );
+    }
+    _inner_loop_cnt = n;
+
+    // loop overhead per iteration using the same inner loop count. subtracted before the stop
+    // rule, so it sees the same rse as `report_to()`. skipped if the target was not reached as
+    // `n` may be huge then
+    if( _target_reached ) {
+      double loop = std::numeric_limits<double>::max();
+      for( int i = 0; i < 5; ++i ) { loop = std::min( loop, sample( n, detail::noop{} ) ); }
+      _offset = std::max( .0, loop / static_cast<double>( n ) );
+    }
+
+    _hwc.open();
+    _hwc.clear();
+    _allocs.clear();
+    _perfc.begin();
+    for( ;; ) {
+      _results.push_back( sample( n, func ) );
+      if( _results.size() < _min_samples ) { continue; }
+      if( clock::now() >= deadline ) { break; }
+      auto const s = detail::stats_t{ _results, n, _offset };
+      if( s.rse() < _max_rse ) { break; }
     }
     _perfc.end();
+    _outer_loop_cnt = static_cast<std::uint32_t>( _results.size() );
+    return *this;
+  }
+
+  // enables or disables hardware performance counters ( enabled by default where supported )
+  config& counters( bool const enabled ) noexcept {
+    _hwc.enable( enabled );
+    return *this;
+  }
+
+  // counts an additional raw pmu event, see `perf list --details` for the encoding
+  config& counter( std::string_view const name, std::uint64_t const raw ) {
+    _hwc.add( name, raw );
     return *this;
   }
 
@@ -431,15 +1292,57 @@ struct config {
     os << sep << pre << "/average = " << s.avg() << std::endl;
     os << sep << pre << "/stddev = " << s.stddev() << std::endl;
     if( _offset != .0 ) { os << sep << pre << "/offset = " << _offset << std::endl; }
+    if( _calibrated ) {
+      os << sep << pre << "/rse = " << s.rse() << std::endl;
+      os << sep << pre << "/inner loop count = " << _inner_loop_cnt << std::endl;
+      os << sep << pre << "/outer loop count = " << _outer_loop_cnt << std::endl;
+      if( ! _target_reached ) {
+        os << sep << pre << "/error = target not reached within the budget, closure optimized away?"
+           << std::endl;
+      }
+    }
+    _hwc.report_to( os, pre, static_cast<double>( _inner_loop_cnt ) );
+    _allocs.report_to( os, pre, static_cast<double>( _inner_loop_cnt ) );
     os << std::endl;
     return *this;
   }
+
+  // writes one json object per line including the raw samples. can be read back by `baseline`
+  config& json_to( std::ostream& os ) noexcept {
+    os << "{\"kind\":\"benchmark\",\"name\":";
+    detail::json_string( os, _name );
+    os << ",\"inner\":" << _inner_loop_cnt << ",\"outer\":" << _outer_loop_cnt << ",\"offset\":";
+    detail::json_number( os, _offset );
+    os << ",\"results\":[";
+    for( std::size_t i = 0; i < _results.size(); ++i ) {
+      if( i > 0 ) os << ",";
+      detail::json_number( os, _results[i] );
+    }
+    os << "]";
+    if( ! _results.empty() ) {
+      os << ",\"stats\":";
+      stats().json_to( os );
+    }
+    os << ",\"rusage\":{\"begin\":";
+    detail::json_to( os, _perfc._rusage_begin );
+    os << ",\"end\":";
+    detail::json_to( os, _perfc._rusage_end );
+    os << "},\"hwc\":";
+    _hwc.json_to( os );
+    os << ",\"alloc\":";
+    _allocs.json_to( os );
+    os << ",\"environment\":";
+    detail::environment::instance().json_to( os );
+    os << "}" << std::endl;
+    return *this;
+  }
 };
 
 class oneshot {
   std::string _name;
   double _delta_t;
   detail::perfc _perfc{};
+  detail::hwc _hwc{};
 
  public:
   template <typename F>
@@ -447,15 +1350,29 @@ class oneshot {
   //typename std::enable_if<noexcept( f() ), oneshot&>::type
   {
     _name = name;
+    _hwc.open();
+    _hwc.clear();
     _perfc.begin();
+    _hwc.sample_begin();
     auto begin = detail::perfc::now();
     f();
     auto end = detail::perfc::now();
+    _hwc.sample_end();
     _delta_t = std::chrono::duration<double, std::nano>( end - begin ).count();
     _perfc.end();
     return *this;
   }
 
+  oneshot& counters( bool const enabled ) noexcept {
+    _hwc.enable( enabled );
+    return *this;
+  }
+
+  oneshot& counter( std::string_view const name, std::uint64_t const raw ) {
+    _hwc.add( name, raw );
+    return *this;
+  }
+
   oneshot& pin( int const cpu = 0x1 ) noexcept {
     detail::perfc::pin( cpu );
     return *this;
@@ -479,6 +1396,492 @@ class oneshot {
     else
       os << "  delta_t = " << _delta_t << "ns" << std::endl;
     _perfc.report_to( os );
+    _hwc.report_to( os, "", 1.0 );
+    return *this;
+  }
+
+  auto& json_to( std::ostream& os ) noexcept {
+    os << "{\"kind\":\"oneshot\",\"name\":";
+    detail::json_string( os, _name );
+    os << ",\"delta_t\":";
+    detail::json_number( os, _delta_t );
+    os << ",\"rusage\":{\"begin\":";
+    detail::json_to( os, _perfc._rusage_begin );
+    os << ",\"end\":";
+    detail::json_to( os, _perfc._rusage_end );
+    os << "},\"hwc\":";
+    _hwc.json_to( os );
+    os << ",\"environment\":";
+    detail::environment::instance().json_to( os );
+    os << "}" << std::endl;
+    return *this;
+  }
+};
+
+struct verdict {
+  std::string _name;
+  bool _known{ false };
+  double _baseline{ .0 };
+  double _current{ .0 };
+  double _change{ .0 };
+  double _p{ 1.0 };
+  bool _regression{ false };
+  bool _improvement{ false };
+
+  verdict& report_to( std::ostream& os ) noexcept {
+    os << "[compare | " << _name << "]" << std::endl;
+    if( ! _known ) {
+      os << "  compare/verdict = no baseline" << std::endl << std::endl;
+      return *this;
+    }
+    os << "  compare/baseline median = " << _baseline << std::endl;
+    os << "  compare/current median = " << _current << std::endl;
+    os << "  compare/change = " << _change << std::endl;
+    os << "  compare/p = " << _p << std::endl;
+    os << "  compare/verdict = "
+       << ( _regression ? "regression" : _improvement ? "improvement" : "unchanged" ) << std::endl;
+    os << std::endl;
+    return *this;
+  }
+};
+
+// per iteration samples of benchmarks read from the json lines written by `config::json_to`.
+// `compare()` flags a benchmark if its median moved by more than `threshold` ( relative ) and the
+// mann-whitney u test rejects "same distribution" at significance level `alpha`
+class baseline {
+  std::map<std::string, std::vector<double>, std::less<>> _entries;
+
+ public:
+  explicit baseline() = default;
+
+  explicit baseline( std::istream& is ) { load( is ); }
+
+  // returns the number of benchmarks read. malformed lines and other kinds are skipped
+  std::size_t load( std::istream& is ) {
+    std::size_t n = 0;
+    for( std::string line; std::getline( is, line ); ) {
+      detail::json_reader r{ line };
+      std::string name;
+      std::string kind;
+      std::string key;
+      double inner = .0;
+      double offset = .0;
+      std::vector<double> results;
+      bool ok = r.eat( '{' );
+      while( ok && ! r.peek( '}' ) ) {
+        ok = r.string( key ) && r.eat( ':' );
+        if( ! ok ) { break; }
+        if( key == "kind" ) {
+          ok = r.string( kind );
+        } else if( key == "name" ) {
+          ok = r.string( name );
+        } else if( key == "inner" ) {
+          ok = r.number( inner );
+        } else if( key == "offset" ) {
+          ok = r.number( offset );
+        } else if( key == "results" ) {
+          ok = r.eat( '[' );
+          double x;
+          while( ok && ! r.eat( ']' ) ) {
+            ok = r.number( x );
+            results.push_back( x );
+            r.eat( ',' );
+          }
+        } else {
+          ok = r.skip();
+        }
+        r.eat( ',' );
+      }
+      if( ! ok || kind != "benchmark" || ! ( inner > .0 ) || results.empty() ) { continue; }
+      if( std::isnan( offset ) ) { offset = .0; }
+      _entries[name] = detail::per_op( results, static_cast<std::uint64_t>( inner ), offset );
+      n++;
+    }
+    return n;
+  }
+
+  std::size_t size() const noexcept { return _entries.size(); }
+
+  bool contains( std::string_view const name ) const noexcept {
+    return _entries.find( name ) != _entries.end();
+  }
+
+  verdict compare( std::string_view const name, std::vector<double> const& current,
+                   double const threshold = 0.05, double const alpha = 0.01 ) const {
+    verdict v;
+    v._name = name;
+    auto const it = _entries.find( name );
+    if( it == _entries.end() || current.empty() ) { return v; }
+    v._known = true;
+    v._baseline = detail::median( it->second );
+    v._current = detail::median( current );
+    v._change = v._baseline != .0 ? ( v._current - v._baseline ) / std::abs( v._baseline ) : .0;
+    v._p = detail::mann_whitney( it->second, current );
+    v._regression = v._p < alpha && v._change > threshold;
+    v._improvement = v._p < alpha && v._change < -threshold;
+    return v;
+  }
+
+  verdict compare( config const& cfg, double const threshold = 0.05,
+                   double const alpha = 0.01 ) const {
+    return compare( cfg._name, detail::per_op( cfg._results, cfg._inner_loop_cnt, cfg._offset ),
+                    threshold, alpha );
+  }
+
+  // compares every benchmark of `current` also present in this baseline
+  std::vector<verdict> compare( baseline const& current, double const threshold = 0.05,
+                                double const alpha = 0.01 ) const {
+    std::vector<verdict> vs;
+    for( auto const& [name, samples] : current._entries ) {
+      if( contains( name ) ) vs.push_back( compare( name, samples, threshold, alpha ) );
+    }
+    return vs;
+  }
+};
+
+// log bucketed ( hdr style ) histogram of non-negative integer values
+//   - values below `2^PRECISION` are recorded exactly
+//   - every power of two above is split into `2^PRECISION` linear sub-buckets, i.e. the relative
+//     error is below `2^-PRECISION`
+//   - fixed size, `record()` never allocates
+//   - histograms can be merged across runs and threads using `merge()`
+class histogram {
+ public:
+  static constexpr unsigned PRECISION = 5;
+  static constexpr std::size_t SUB_BUCKETS = std::size_t{ 1 } << PRECISION;
+  static constexpr std::size_t BUCKETS = ( 64 - PRECISION + 1 ) * SUB_BUCKETS;
+
+ private:
+  std::array<std::uint64_t, BUCKETS> _counts{};
+  std::uint64_t _total{ 0 };
+  std::uint64_t _min{ std::numeric_limits<std::uint64_t>::max() };
+  std::uint64_t _max{ 0 };
+  double _sum{ .0 };
+
+ public:
+  static inline std::size_t index( std::uint64_t const v ) noexcept {
+    if( v < SUB_BUCKETS ) { return static_cast<std::size_t>( v ); }
+    auto const e = static_cast<unsigned>( 63 - __builtin_clzll( v ) );
+    auto const sub = ( v >> ( e - PRECISION ) ) & ( SUB_BUCKETS - 1 );
+    return ( e - PRECISION + 1 ) * SUB_BUCKETS + static_cast<std::size_t>( sub );
+  }
+
+  // largest value mapping to bucket `i`
+  static inline std::uint64_t highest( std::size_t const i ) noexcept {
+    if( i < SUB_BUCKETS ) { return i; }
+    auto const e = static_cast<unsigned>( i / SUB_BUCKETS + PRECISION - 1 );
+    auto const lo = static_cast<std::uint64_t>( SUB_BUCKETS + i % SUB_BUCKETS ) << ( e - PRECISION );
+    return lo + ( ( std::uint64_t{ 1 } << ( e - PRECISION ) ) - 1 );
+  }
+
+  inline void record( std::uint64_t const v ) noexcept {
+    _counts[index( v )]++;
+    _total++;
+    _sum += static_cast<double>( v );
+    _min = std::min( _min, v );
+    _max = std::max( _max, v );
+  }
+
+  void merge( histogram const& other ) noexcept {
+    for( std::size_t i = 0; i < BUCKETS; ++i ) _counts[i] += other._counts[i];
+    _total += other._total;
+    _sum += other._sum;
+    _min = std::min( _min, other._min );
+    _max = std::max( _max, other._max );
+  }
+
+  void clear() noexcept {
+    _counts.fill( 0 );
+    _total = 0;
+    _sum = .0;
+    _min = std::numeric_limits<std::uint64_t>::max();
+    _max = 0;
+  }
+
+  inline std::uint64_t count() const noexcept { return _total; }
+
+  inline std::uint64_t min() const noexcept { return _total == 0 ? 0 : _min; }
+
+  inline std::uint64_t max() const noexcept { return _max; }
+
+  inline double avg() const noexcept {
+    return _total == 0 ? .0 : _sum / static_cast<double>( _total );
+  }
+
+  // value at percentile `p` in `[0, 100]`. reported as the upper bound of its bucket
+  std::uint64_t percentile( double const p ) const noexcept {
+    if( _total == 0 ) { return 0; }
+    auto const rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>( std::ceil( p / 100.0 * static_cast<double>( _total ) ) ) );
+    std::uint64_t seen = 0;
+    for( std::size_t i = 0; i < BUCKETS; ++i ) {
+      seen += _counts[i];
+      if( seen >= rank ) { return std::min( highest( i ), _max ); }
+    }
+    return _max;
+  }
+};
+
+// times every single invocation of a closure and records the latency ( in ns ) into a `histogram`
+// to expose the tail hidden by the batch averages of `config`
+class latency {
+  std::string _name;
+  std::uint64_t _cnt{ 1'000'000 };
+  std::uint64_t _overhead{ 0 };
+  histogram _histogram;
+
+ public:
+  latency& n( std::uint64_t const cnt ) noexcept {
+    _cnt = cnt;
+    return *this;
+  }
+
+  template <typename F>
+  latency& run( std::string_view const name, F&& f ) noexcept {
+    auto const& clock = detail::tsc::instance();
+    auto const scale = clock.ns_per_tick();
+    _name = name;
+    _histogram.clear();
+    // cost of two back to back timestamps is subtracted from every sample
+    std::uint64_t overhead = std::numeric_limits<std::uint64_t>::max();
+    for( int i = 0; i < 1000; ++i ) {
+      auto const t0 = clock.ticks();
+      auto const t1 = clock.ticks();
+      overhead = std::min( overhead, t1 - t0 );
+    }
+    _overhead = static_cast<std::uint64_t>( static_cast<double>( overhead ) * scale );
+    for( std::uint64_t i = 0; i < _cnt; ++i ) {
+      auto const t0 = clock.ticks();
+      f();
+      auto const t1 = clock.ticks();
+      auto const delta = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+      _histogram.record( static_cast<std::uint64_t>( static_cast<double>( delta ) * scale ) );
+    }
+    return *this;
+  }
+
+  template <typename... Args>
+  latency& touch( Args&&... args ) noexcept {
+    (void)std::initializer_list<int>{
+        ( detail::doNotOptimizeAway( std::forward<Args>( args ) ), 0 )... };
+    return *this;
+  }
+
+  histogram& hist() noexcept { return _histogram; }
+
+  latency& merge( histogram const& other ) noexcept {
+    _histogram.merge( other );
+    return *this;
+  }
+
+  latency& report_to( std::ostream& os ) noexcept {
+    os << "[latency | " << _name << "]" << std::endl;
+    os << "  latency/count = " << _histogram.count() << std::endl;
+    os << "  latency/min = " << _histogram.min() << "ns" << std::endl;
+    os << "  latency/average = " << _histogram.avg() << "ns" << std::endl;
+    os << "  latency/p50 = " << _histogram.percentile( 50.0 ) << "ns" << std::endl;
+    os << "  latency/p90 = " << _histogram.percentile( 90.0 ) << "ns" << std::endl;
+    os << "  latency/p99 = " << _histogram.percentile( 99.0 ) << "ns" << std::endl;
+    os << "  latency/p99.9 = " << _histogram.percentile( 99.9 ) << "ns" << std::endl;
+    os << "  latency/max = " << _histogram.max() << "ns" << std::endl;
+    os << "  latency/overhead = " << _overhead << "ns" << std::endl;
+    os << std::endl;
+    return *this;
+  }
+};
+
+enum class placement {
+  compact, // fill up one numa node before using the next
+  scatter  // round robin over numa nodes
+};
+
+// runs a closure concurrently on `n` pinned threads to measure throughput under contention
+//   - all threads start every sample together from a spin barrier
+//   - collects per thread `stats_t` and reports aggregate ops/s and the spread between threads
+//   - `sweep()` repeats this for 1, 2, 4, ... threads to get a scaling curve
+// the closure is either called without arguments or with the index of the calling thread
+class scaling {
+  struct point {
+    std::size_t _threads;
+    std::size_t _cpus;
+    double _wall;
+    std::vector<std::vector<double>> _results;
+  };
+
+  std::string _name;
+  std::uint64_t _inner_loop_cnt{ 100'000 };
+  std::uint32_t _outer_loop_cnt{ 23 };
+  placement _placement{ placement::compact };
+  std::vector<int> _cpus;
+  std::vector<point> _points;
+
+  std::vector<int> layout() const {
+    if( ! _cpus.empty() ) { return _cpus; }
+    auto const nodes = detail::numa_nodes();
+    std::vector<int> cpus;
+    if( _placement == placement::compact ) {
+      for( auto const& node : nodes ) cpus.insert( cpus.end(), node.begin(), node.end() );
+    } else {
+      for( std::size_t i = 0;; ++i ) {
+        auto const n = cpus.size();
+        for( auto const& node : nodes ) {
+          if( i < node.size() ) cpus.push_back( node[i] );
+        }
+        if( cpus.size() == n ) break;
+      }
+    }
+    return cpus;
+  }
+
+  template <typename F>
+  void measure( std::size_t const n, F& f ) {
+    auto const cpus = layout();
+    detail::spin_barrier barrier{ n };
+    std::vector<std::vector<std::chrono::steady_clock::time_point>> stamps( n );
+    std::vector<std::thread> workers;
+    workers.reserve( n );
+    for( std::size_t k = 0; k < n; ++k ) {
+      workers.emplace_back( [&, k]() {
+        detail::perfc::pin( cpus[k % cpus.size()] );
+        auto& ts = stamps[k];
+        ts.reserve( 2 * _outer_loop_cnt );
+        for( std::uint32_t i = 0; i < _outer_loop_cnt; ++i ) {
+          barrier.wait();
+          ts.push_back( detail::perfc::now() );
+          for( std::uint64_t j = 0; j < _inner_loop_cnt; ++j ) {
+            if constexpr( std::is_invocable_v<F&, std::size_t> ) {
+              f( k );
+            } else {
+              f();
+            }
+          }
+          ts.push_back( detail::perfc::now() );
+        }
+      } );
+    }
+    for( auto& w : workers ) w.join();
+
+    point pt{ n, cpus.size(), .0, std::vector<std::vector<double>>( n ) };
+    for( std::uint32_t i = 0; i < _outer_loop_cnt; ++i ) {
+      auto begin = stamps[0][2 * i];
+      auto end = stamps[0][2 * i + 1];
+      for( std::size_t k = 0; k < n; ++k ) {
+        begin = std::min( begin, stamps[k][2 * i] );
+        end = std::max( end, stamps[k][2 * i + 1] );
+        pt._results[k].push_back(
+            std::chrono::duration<double, std::nano>( stamps[k][2 * i + 1] - stamps[k][2 * i] )
+                .count() );
+      }
+      pt._wall += std::chrono::duration<double, std::nano>( end - begin ).count();
+    }
+    _points.push_back( std::move( pt ) );
+  }
+
+  double ops_per_second( point const& pt ) const noexcept {
+    auto const ops = static_cast<double>( pt._threads ) * static_cast<double>( _inner_loop_cnt ) *
+        static_cast<double>( _outer_loop_cnt );
+    return pt._wall > .0 ? ops / pt._wall * 1'000'000'000.0 : .0;
+  }
+
+ public:
+  scaling& i( std::uint64_t const inner_loop_cnt ) noexcept {
+    _points.clear();
+    _inner_loop_cnt = inner_loop_cnt;
+    return *this;
+  }
+
+  scaling& o( std::uint32_t const outer_loop_cnt ) noexcept {
+    _points.clear();
+    _outer_loop_cnt = outer_loop_cnt;
+    return *this;
+  }
+
+  // explicit cpus to pin to. thread `k` is pinned to `cpus[k % cpus.size()]`
+  scaling& cpus( std::vector<int> cpus ) noexcept {
+    _cpus = std::move( cpus );
+    return *this;
+  }
+
+  scaling& place( placement const p ) noexcept {
+    _placement = p;
+    return *this;
+  }
+
+  template <typename F>
+  scaling& run( std::string_view const name, std::size_t const threads, F&& f ) {
+    _name = name;
+    _points.clear();
+    measure( std::max<std::size_t>( 1, threads ), f );
+    return *this;
+  }
+
+  // measures 1, 2, 4, ... threads up to `max_threads` ( default: all cpus used for placement, i.e.
+  // `cpus()` or the cpus in the affinity mask )
+  template <typename F>
+  scaling& sweep( std::string_view const name, F&& f, std::size_t max_threads = 0 ) {
+    _name = name;
+    _points.clear();
+    if( max_threads == 0 ) { max_threads = std::max<std::size_t>( 1, layout().size() ); }
+    std::size_t n = 1;
+    for( ; n < max_threads; n *= 2 ) measure( n, f );
+    measure( max_threads, f );
+    return *this;
+  }
+
+  template <typename... Args>
+  scaling& touch( Args&&... args ) noexcept {
+    (void)std::initializer_list<int>{
+        ( detail::doNotOptimizeAway( std::forward<Args>( args ) ), 0 )... };
+    return *this;
+  }
+
+  std::size_t size() const noexcept { return _points.size(); }
+
+  std::size_t threads( std::size_t const which ) const noexcept { return _points[which]._threads; }
+
+  double ops_per_second( std::size_t const which ) const noexcept {
+    return ops_per_second( _points[which] );
+  }
+
+  detail::stats_t stats( std::size_t const which, std::size_t const thread ) const noexcept {
+    return detail::stats_t{ _points[which]._results[thread], _inner_loop_cnt, .0 };
+  }
+
+  scaling& report_to( std::ostream& os ) noexcept {
+    os << "[scaling | " << _name << "]" << std::endl;
+    // speedup and efficiency are relative to a single thread, i.e. only known after `sweep()`
+    auto const base =
+        _points.empty() || _points.front()._threads != 1 ? .0 : ops_per_second( _points.front() );
+    for( std::size_t p = 0; p < _points.size(); ++p ) {
+      auto const& pt = _points[p];
+      auto const ops = ops_per_second( pt );
+      auto const pre = "  threads/" + std::to_string( pt._threads );
+      // fairness: slowest over fastest thread average, 1 is perfectly fair
+      double lo = std::numeric_limits<double>::max();
+      double hi = .0;
+      for( std::size_t k = 0; k < pt._threads; ++k ) {
+        auto const avg = stats( p, k ).avg();
+        lo = std::min( lo, avg );
+        hi = std::max( hi, avg );
+      }
+      os << pre << "/ops per second = " << ops << std::endl;
+      if( pt._threads > pt._cpus ) {
+        os << pre << "/oversubscribed = " << pt._threads << " threads on " << pt._cpus << " cpus"
+           << std::endl;
+      }
+      if( base > .0 ) {
+        auto const speedup = ops / base;
+        os << pre << "/speedup = " << speedup << std::endl;
+        os << pre << "/efficiency = " << ( speedup / static_cast<double>( pt._threads ) ) << std::endl;
+      }
+      os << pre << "/fairness = " << ( hi > .0 ? lo / hi : 1.0 ) << std::endl;
+      for( std::size_t k = 0; k < pt._threads; ++k ) {
+        auto const s = stats( p, k );
+        os << pre << "/thread/" << k << "/average = " << s.avg() << std::endl;
+        os << pre << "/thread/" << k << "/stddev = " << s.stddev() << std::endl;
+      }
+    }
+    os << std::endl;
     return *this;
   }
 };
@@ -0,0 +1,346 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+// ycsb style key / operation streams for load tests
+//
+// @see
+//   - <https://github.com/brianfrankcooper/YCSB/wiki/Core-Workloads>
+//   - Benchmarking Cloud Serving Systems with YCSB, Cooper et al, SoCC 2010
+
+#pragma once
+
+#include <pest/lemire-distribution.hxx>
+#include <pest/xoshiro.hxx>
+#include <pest/zipfian-distribution.hxx>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __clang__
+#  pragma clang diagnostic push
+#  pragma clang diagnostic ignored "-Wpadded"
+#endif
+
+namespace emptyspace::workload {
+
+enum class op : std::uint8_t { read, update, insert, read_modify_write };
+
+enum class distribution {
+  uniform, // all existing keys are equally likely
+  zipfian, // scrambled zipfian over the initial keys
+  hotspot, // `_hot_ops` of the requests go to the first `_hot_set` of the keys
+  latest   // zipfian over the age of the keys, i.e. recently inserted keys are the hottest
+};
+
+struct spec {
+  // size of the initial key space `[0, _records)`. inserts append new keys
+  std::uint64_t _records{ 1'000'000 };
+  std::uint64_t _operations{ 10'000'000 };
+  // ratios of the operations, normalized by their sum
+  double _read{ 1.0 };
+  double _update{ .0 };
+  double _insert{ .0 };
+  double _read_modify_write{ .0 };
+  distribution _distribution{ distribution::zipfian };
+  double _theta{ 0.99 };
+  double _hot_set{ 0.2 };
+  double _hot_ops{ 0.8 };
+  std::uint64_t _seed{ 1 };
+
+  // the ycsb core workloads ( e is left out because it needs scans )
+  static spec a() noexcept { return with( .5, .5, .0, .0, distribution::zipfian ); }
+  static spec b() noexcept { return with( .95, .05, .0, .0, distribution::zipfian ); }
+  static spec c() noexcept { return with( 1.0, .0, .0, .0, distribution::zipfian ); }
+  static spec d() noexcept { return with( .95, .0, .05, .0, distribution::latest ); }
+  static spec f() noexcept { return with( .5, .0, .0, .5, distribution::zipfian ); }
+
+  static spec with( double const read, double const update, double const insert, double const rmw,
+                    distribution const dist ) noexcept {
+    spec s;
+    s._read = read;
+    s._update = update;
+    s._insert = insert;
+    s._read_modify_write = rmw;
+    s._distribution = dist;
+    return s;
+  }
+};
+
+namespace detail {
+
+using rng_type = xoshiro::xoshiro256starstar64;
+
+// operations are generated in chunks of this size. chunk `c` uses the seed generator jumped `c`
+// times, which makes the stream independent of the number of threads generating it
+inline constexpr std::uint64_t CHUNK = 1u << 16;
+
+// probability `p` as a threshold for 64 bit random values. saturates, 2^64 is not representable
+inline std::uint64_t threshold( double const p ) noexcept {
+  if( ! ( p > .0 ) ) { return 0; }
+  if( p >= 1.0 ) { return ~std::uint64_t( 0 ); }
+  return static_cast<std::uint64_t>( p * 18446744073709551616.0 );
+}
+
+// fixed point thresholds to pick an operation from a single 64 bit random value
+struct op_picker {
+  std::uint64_t _thresholds[3];
+
+  explicit op_picker( spec const& s ) noexcept {
+    auto const sum = s._read + s._update + s._insert + s._read_modify_write;
+    auto const scale = sum > .0 ? 18446744073709551615.0 / sum : .0;
+    double acc = .0;
+    double const ratios[3] = { s._read, s._update, s._insert };
+    for( int i = 0; i < 3; ++i ) {
+      acc += ratios[i];
+      _thresholds[i] = acc * scale >= 18446744073709551615.0
+                           ? ~std::uint64_t( 0 )
+                           : static_cast<std::uint64_t>( acc * scale );
+    }
+  }
+
+  inline op operator()( std::uint64_t const x ) const noexcept {
+    if( x < _thresholds[0] ) return op::read;
+    if( x < _thresholds[1] ) return op::update;
+    if( x < _thresholds[2] ) return op::insert;
+    return op::read_modify_write;
+  }
+};
+
+struct mapping {
+  void* _data{ MAP_FAILED };
+  std::size_t _size{ 0 };
+
+  ~mapping() noexcept {
+    if( _data != MAP_FAILED ) { munmap( _data, _size ); }
+  }
+};
+
+} // namespace detail
+
+// one request of a stream
+struct request {
+  std::uint64_t _key;
+  op _op;
+};
+
+// preallocated stream of requests. generated once up front so the measured loop only consumes keys
+// and can be saved to / replayed from a file ( memory mapped )
+class stream {
+  std::shared_ptr<void> _storage;
+  std::uint64_t const* _keys{ nullptr };
+  op const* _ops{ nullptr };
+  std::size_t _size{ 0 };
+
+  static constexpr char MAGIC[8] = { 'p', 'e', 's', 't', 'w', 'l', '0', '1' };
+
+  static void chunk_ops( spec const& s, std::uint64_t const c, detail::rng_type rng, op* const ops ) {
+    auto const begin = c * detail::CHUNK;
+    auto const end = std::min( s._operations, begin + detail::CHUNK );
+    detail::op_picker const pick{ s };
+    for( auto i = begin; i < end; ++i ) ops[i] = pick( rng() );
+  }
+
+  static void chunk_keys( spec const& s, std::uint64_t const c, std::uint64_t const inserted,
+                          detail::rng_type rng, std::uint64_t* const keys, op const* const ops ) {
+    auto const begin = c * detail::CHUNK;
+    auto const end = std::min( s._operations, begin + detail::CHUNK );
+    auto const records = std::max<std::uint64_t>( 1, s._records );
+    auto const hot = std::clamp<std::uint64_t>(
+        static_cast<std::uint64_t>( s._hot_set * static_cast<double>( records ) ), 1, records );
+    scrambled_zipfian_int_distribution<std::uint64_t> zipf{ 0, records - 1, s._theta, s._seed };
+    zipfian_int_distribution<std::uint64_t> age{ 0, records - 1, s._theta };
+    auto const hot_ops = detail::threshold( s._hot_ops );
+    auto n = records + inserted;
+    for( auto i = begin; i < end; ++i ) {
+      if( ops[i] == op::insert ) {
+        keys[i] = n++;
+        continue;
+      }
+      switch( s._distribution ) {
+        case distribution::uniform:
+          keys[i] = lemire_distribution<std::uint64_t>{ 0, n - 1 }( rng );
+          break;
+        case distribution::zipfian: keys[i] = zipf( rng ); break;
+        case distribution::hotspot:
+          if( rng() < hot_ops || hot_ops == ~std::uint64_t( 0 ) || hot == records ) {
+            keys[i] = lemire_distribution<std::uint64_t>{ 0, hot - 1 }( rng );
+          } else {
+            keys[i] = lemire_distribution<std::uint64_t>{ hot, records - 1 }( rng );
+          }
+          break;
+        case distribution::latest: keys[i] = n - 1 - std::min( age( rng ), n - 1 ); break;
+      }
+    }
+  }
+
+  // runs `f( c )` for every chunk on `threads` threads
+  template <typename F>
+  static void parallel( std::uint64_t const chunks, unsigned threads, F const& f ) {
+    threads = std::max( 1u, std::min<unsigned>( threads, static_cast<unsigned>( chunks ) ) );
+    std::vector<std::thread> pool;
+    for( unsigned t = 1; t < threads; ++t ) {
+      pool.emplace_back( [&, t]() {
+        for( auto c = std::uint64_t{ t }; c < chunks; c += threads ) f( c );
+      } );
+    }
+    for( std::uint64_t c = 0; c < chunks; c += threads ) f( c );
+    for( auto& p : pool ) p.join();
+  }
+
+ public:
+  // generates the stream described by `s` using `threads` threads. the result does not depend on
+  // the number of threads
+  static stream generate( spec const& s,
+                          unsigned const threads = std::thread::hardware_concurrency() ) {
+    auto const n = static_cast<std::size_t>( s._operations );
+    auto storage = std::make_shared<std::pair<std::vector<std::uint64_t>, std::vector<op>>>();
+    storage->first.resize( n );
+    storage->second.resize( n );
+    auto* const keys = storage->first.data();
+    auto* const ops = storage->second.data();
+    auto const chunks = ( s._operations + detail::CHUNK - 1 ) / detail::CHUNK;
+
+    // chunk `c` starts at the seed generator jumped `c` times. keys use a second set of streams
+    // separated by `long_jump()` from the operations. one jump per chunk, done up front
+    std::vector<detail::rng_type> op_rngs;
+    std::vector<detail::rng_type> key_rngs;
+    op_rngs.reserve( chunks );
+    key_rngs.reserve( chunks );
+    detail::rng_type rng{ s._seed };
+    detail::rng_type krng{ s._seed };
+    krng.long_jump();
+    for( std::uint64_t c = 0; c < chunks; ++c ) {
+      op_rngs.push_back( rng );
+      key_rngs.push_back( krng );
+      rng.jump();
+      krng.jump();
+    }
+
+    // pass 1: operations, pass 2: keys. inserts need the number of inserts of all previous chunks
+    parallel( chunks, threads, [&]( std::uint64_t const c ) { chunk_ops( s, c, op_rngs[c], ops ); } );
+    std::vector<std::uint64_t> inserted( chunks + 1, 0 );
+    for( std::uint64_t c = 0; c < chunks; ++c ) {
+      auto const begin = ops + c * detail::CHUNK;
+      auto const end = ops + std::min( s._operations, ( c + 1 ) * detail::CHUNK );
+      inserted[c + 1] =
+          inserted[c] + static_cast<std::uint64_t>( std::count( begin, end, op::insert ) );
+    }
+    parallel( chunks, threads, [&]( std::uint64_t const c ) {
+      chunk_keys( s, c, inserted[c], key_rngs[c], keys, ops );
+    } );
+
+    stream st;
+    st._keys = keys;
+    st._ops = ops;
+    st._size = n;
+    st._storage = std::move( storage );
+    return st;
+  }
+
+  // writes the stream to `path` so it can be replayed using `load()`
+  void save( std::string const& path ) const {
+    auto const fd = ::open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if( fd < 0 ) { throw std::runtime_error( "workload: cannot open " + path ); }
+    auto const size = static_cast<std::uint64_t>( _size );
+    auto const put = [fd]( void const* data, std::size_t n ) {
+      auto const* p = static_cast<char const*>( data );
+      while( n > 0 ) {
+        auto const w = ::write( fd, p, n );
+        if( w <= 0 ) { return false; }
+        p += w;
+        n -= static_cast<std::size_t>( w );
+      }
+      return true;
+    };
+    auto const ok = put( MAGIC, sizeof( MAGIC ) ) && put( &size, sizeof( size ) ) &&
+        put( _keys, _size * sizeof( std::uint64_t ) ) && put( _ops, _size * sizeof( op ) );
+    ::close( fd );
+    if( ! ok ) { throw std::runtime_error( "workload: cannot write " + path ); }
+  }
+
+  // maps a stream written by `save()` read only into memory
+  static stream load( std::string const& path ) {
+    auto const fd = ::open( path.c_str(), O_RDONLY );
+    if( fd < 0 ) { throw std::runtime_error( "workload: cannot open " + path ); }
+    struct stat sb;
+    if( fstat( fd, &sb ) != 0 || static_cast<std::size_t>( sb.st_size ) < 16 ) {
+      ::close( fd );
+      throw std::runtime_error( "workload: not a stream " + path );
+    }
+    auto m = std::make_shared<detail::mapping>();
+    m->_size = static_cast<std::size_t>( sb.st_size );
+    int flags = MAP_PRIVATE;
+#if defined( MAP_POPULATE )
+    // pre-fault so replaying does not page fault inside the measured loop
+    flags |= MAP_POPULATE;
+#endif
+    m->_data = mmap( nullptr, m->_size, PROT_READ, flags, fd, 0 );
+    ::close( fd );
+    if( m->_data == MAP_FAILED ) { throw std::runtime_error( "workload: cannot map " + path ); }
+    auto const* base = static_cast<char const*>( m->_data );
+    std::uint64_t size;
+    std::memcpy( &size, base + sizeof( MAGIC ), sizeof( size ) );
+    if( std::memcmp( base, MAGIC, sizeof( MAGIC ) ) != 0 ||
+        m->_size != 16 + size * ( sizeof( std::uint64_t ) + sizeof( op ) ) ) {
+      throw std::runtime_error( "workload: not a stream " + path );
+    }
+    stream st;
+    st._keys = reinterpret_cast<std::uint64_t const*>( base + 16 );
+    st._ops = reinterpret_cast<op const*>( base + 16 + size * sizeof( std::uint64_t ) );
+    st._size = static_cast<std::size_t>( size );
+    st._storage = std::move( m );
+    return st;
+  }
+
+  std::size_t size() const noexcept { return _size; }
+
+  std::uint64_t const* keys() const noexcept { return _keys; }
+
+  op const* ops() const noexcept { return _ops; }
+
+  request operator[]( std::size_t const i ) const noexcept { return { _keys[i], _ops[i] }; }
+
+  // endless cursor over the stream, wraps around at the end
+  class cursor {
+    stream const* _stream;
+    std::size_t _next{ 0 };
+
+   public:
+    explicit cursor( stream const& s ) noexcept : _stream{ &s } {}
+
+    inline request operator()() noexcept {
+      if( _next == _stream->_size ) { _next = 0; }
+      auto const i = _next++;
+      return { _stream->_keys[i], _stream->_ops[i] };
+    }
+  };
+
+  cursor begin() const noexcept { return cursor{ *this }; }
+
+  // wraps `f( key, op )` into a closure consuming one request per call, e.g. for
+  // `pnch::config::run( "ycsb-a", s.replay( [&]( auto key, auto op ) { ... } ) )`
+  template <typename F>
+  auto replay( F f ) const noexcept {
+    return [c = cursor{ *this }, f = std::move( f )]() mutable {
+      auto const r = c();
+      f( r._key, r._op );
+    };
+  }
+};
+
+} // namespace emptyspace::workload
+
+#ifdef __clang__
+#  pragma clang diagnostic pop
+#endif
@@ -25,12 +25,48 @@ generates them.
   - <http://xoshiro.di.unimi.it/xoshiro512starstar.c>
 */
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
 
 namespace emptyspace::xoshiro {
 
 namespace detail {
 
+// jump polynomials ( from the reference implementations ) advancing a generator by `2^(n/2)`
+// ( `JUMP` ) and `2^(3n/4)` ( `LONG_JUMP` ) steps for `n` state bits. only known for the
+// recommended parameters, i.e. `jump()` does not compile for the specialized variants
+template <typename itype, unsigned int a, unsigned int b>
+struct jump_polynomial;
+
+template <>
+struct jump_polynomial<uint64_t, 17, 45> {
+  static constexpr uint64_t JUMP[4] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa,
+                                        0x39abdc4529b1661c };
+  static constexpr uint64_t LONG_JUMP[4] = { 0x76e15d3efefdcbbf, 0xc5004e441c522fb3,
+                                             0x77710069854ee241, 0x39109bb02acbe635 };
+};
+
+template <>
+struct jump_polynomial<uint32_t, 9, 11> {
+  static constexpr uint32_t JUMP[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+  static constexpr uint32_t LONG_JUMP[4] = { 0xb523952e, 0x0b6f099f, 0xccf5a0ef, 0x1c580662 };
+};
+
+template <>
+struct jump_polynomial<uint64_t, 11, 21> {
+  static constexpr uint64_t JUMP[8] = { 0x33ed89b6e7a353f9, 0x760083d7955323be, 0x2837f2fbb5f22fae,
+                                        0x4b8c5674d309511c, 0xb11ac47a7ba28c25, 0xf1be7667092bcc1c,
+                                        0x53851efdb6df0aaf, 0x1ebbc8b23eaf25db };
+  static constexpr uint64_t LONG_JUMP[8] = { 0x11467fef8f921d28, 0xa2a819f2e79c8ea8,
+                                             0xa8299fc284b3959a, 0xb4d347340ca63ee1,
+                                             0x1cb0940bedbff6ce, 0xd956c5c4fa1f8e17,
+                                             0x915e38fd4eda93bc, 0x5b3ccdfa5d7daca5 };
+};
+
 template <typename itype, typename rtype, unsigned int a, unsigned int b>
 class xoshiro_x4 {
  protected:
@@ -39,14 +75,19 @@ class xoshiro_x4 {
   static constexpr unsigned int ITYPE_BITS = 8 * sizeof( itype );
   static constexpr unsigned int RTYPE_BITS = 8 * sizeof( rtype );
 
-  static inline itype rotl( itype const x, unsigned const k ) noexcept {
-    return static_cast<itype>( ( x << k ) | ( x >> ( ITYPE_BITS - k ) ) );
+  // `V` is either `itype` or a vector of `itype` ( see `bulk` ). vectors wider than the target
+  // supports change the abi when passed by value ( `-Wpsabi` ), so these only use references
+  template <typename V>
+  static inline void rotl( V& x, unsigned const k ) noexcept {
+    x = static_cast<V>( ( x << k ) | ( x >> ( ITYPE_BITS - k ) ) );
   }
 
  public:
   using state_type = itype;
   using result_type = rtype;
 
+  static constexpr std::size_t WORDS = 4;
+
   static constexpr result_type min() { return 0; }
   static constexpr result_type max() { return ~result_type( 0 ); }
 
@@ -70,19 +111,50 @@ class xoshiro_x4 {
     for( int i = 0; i < 16; ++i ) advance();
   }
 
-  void advance() {
-    const uint64_t t = static_cast<uint64_t>( s1_ ) << a;
+  template <typename V>
+  static inline void step( V& s0, V& s1, V& s2, V& s3 ) noexcept {
+    V const t = static_cast<V>( s1 << a );
+
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
 
-    s2_ ^= s0_;
-    s3_ ^= s1_;
-    s1_ ^= s2_;
-    s0_ ^= s3_;
+    s2 ^= t;
 
-    s2_ ^= t;
+    rotl( s3, b );
+  }
 
-    s3_ = rotl( s3_, b );
+  void advance() { step( s0_, s1_, s2_, s3_ ); }
+
+  std::array<itype, WORDS> state() const noexcept { return { s0_, s1_, s2_, s3_ }; }
+
+  // advances the generator by the polynomial `poly` ( little endian bit order )
+  void jump( itype const ( &poly )[WORDS] ) noexcept {
+    itype t0 = 0, t1 = 0, t2 = 0, t3 = 0;
+    for( auto const w : poly ) {
+      for( unsigned k = 0; k < ITYPE_BITS; ++k ) {
+        if( ( w >> k ) & 1u ) {
+          t0 ^= s0_;
+          t1 ^= s1_;
+          t2 ^= s2_;
+          t3 ^= s3_;
+        }
+        advance();
+      }
+    }
+    s0_ = t0;
+    s1_ = t1;
+    s2_ = t2;
+    s3_ = t3;
   }
 
+  // equivalent to `2^(ITYPE_BITS * 2)` calls. use it to hand out non-overlapping streams to threads
+  void jump() noexcept { jump( jump_polynomial<itype, a, b>::JUMP ); }
+
+  // equivalent to `2^(ITYPE_BITS * 3)` calls. use it to hand out non-overlapping groups of streams
+  void long_jump() noexcept { jump( jump_polynomial<itype, a, b>::LONG_JUMP ); }
+
   bool operator==( const xoshiro_x4& rhs ) {
     return s0_ == rhs.s0_ && ( s1_ == rhs.s1_ ) && ( s2_ == rhs.s2_ ) && ( s3_ == rhs.s3_ );
   }
@@ -90,7 +162,7 @@ class xoshiro_x4 {
   bool operator!=( const xoshiro_x4& rhs ) { return ! operator==( rhs ); }
 
   // Not (yet) implemented:
-  //   - arbitrary jumpahead (doable, but annoying to write).
+  //   - arbitrary jumpahead (only the fixed `jump()` and `long_jump()` exist).
   //   - I/O
   //   - Seeding from a seed_seq.
 };
@@ -103,12 +175,17 @@ class xoshiro_x8 {
   static constexpr unsigned int ITYPE_BITS = 8 * sizeof( itype );
   static constexpr unsigned int RTYPE_BITS = 8 * sizeof( rtype );
 
-  static inline itype rotl( const itype x, int k ) { return x << k | ( x >> ( ITYPE_BITS - k ) ); }
+  template <typename V>
+  static inline void rotl( V& x, unsigned const k ) noexcept {
+    x = static_cast<V>( x << k | ( x >> ( ITYPE_BITS - k ) ) );
+  }
 
  public:
   using state_type = itype;
   using result_type = rtype;
 
+  static constexpr std::size_t WORDS = 8;
+
   static constexpr result_type min() { return 0; }
   static constexpr result_type max() { return ~result_type( 0 ); }
 
@@ -139,23 +216,64 @@ class xoshiro_x8 {
     for( int i = 0; i < 16; ++i ) advance();
   }
 
-  void advance() {
-    const uint64_t t = s1_ << a;
+  template <typename V>
+  static inline void step( V& s0, V& s1, V& s2, V& s3, V& s4, V& s5, V& s6, V& s7 ) noexcept {
+    V const t = static_cast<V>( s1 << a );
+
+    s2 ^= s0;
+    s5 ^= s1;
+    s1 ^= s2;
+    s7 ^= s3;
+    s3 ^= s4;
+    s4 ^= s5;
+    s0 ^= s6;
+    s6 ^= s7;
+
+    s6 ^= t;
 
-    s2_ ^= s0_;
-    s5_ ^= s1_;
-    s1_ ^= s2_;
-    s7_ ^= s3_;
-    s3_ ^= s4_;
-    s4_ ^= s5_;
-    s0_ ^= s6_;
-    s6_ ^= s7_;
+    rotl( s7, b );
+  }
+
+  void advance() { step( s0_, s1_, s2_, s3_, s4_, s5_, s6_, s7_ ); }
 
-    s6_ ^= t;
+  std::array<itype, WORDS> state() const noexcept {
+    return { s0_, s1_, s2_, s3_, s4_, s5_, s6_, s7_ };
+  }
 
-    s7_ = rotl( s7_, b );
+  // advances the generator by the polynomial `poly` ( little endian bit order )
+  void jump( itype const ( &poly )[WORDS] ) noexcept {
+    itype t[WORDS] = {};
+    for( auto const w : poly ) {
+      for( unsigned k = 0; k < ITYPE_BITS; ++k ) {
+        if( ( w >> k ) & 1u ) {
+          t[0] ^= s0_;
+          t[1] ^= s1_;
+          t[2] ^= s2_;
+          t[3] ^= s3_;
+          t[4] ^= s4_;
+          t[5] ^= s5_;
+          t[6] ^= s6_;
+          t[7] ^= s7_;
+        }
+        advance();
+      }
+    }
+    s0_ = t[0];
+    s1_ = t[1];
+    s2_ = t[2];
+    s3_ = t[3];
+    s4_ = t[4];
+    s5_ = t[5];
+    s6_ = t[6];
+    s7_ = t[7];
   }
 
+  // equivalent to `2^256` calls
+  void jump() noexcept { jump( jump_polynomial<itype, a, b>::JUMP ); }
+
+  // equivalent to `2^384` calls
+  void long_jump() noexcept { jump( jump_polynomial<itype, a, b>::LONG_JUMP ); }
+
   bool operator==( const xoshiro_x8& rhs ) {
     return s0_ == rhs.s0_ && ( s1_ == rhs.s1_ ) && ( s2_ == rhs.s2_ ) && ( s3_ == rhs.s3_ ) &&
         ( s4_ == rhs.s4_ ) && ( s5_ == rhs.s5_ ) && ( s6_ == rhs.s6_ ) && ( s7_ == rhs.s7_ );
@@ -164,7 +282,7 @@ class xoshiro_x8 {
   bool operator!=( const xoshiro_x8& rhs ) { return ! operator==( rhs ); }
 
   // Not (yet) implemented:
-  //   - arbitrary jumpahead (doable, but annoying to write).
+  //   - arbitrary jumpahead (only the fixed `jump()` and `long_jump()` exist).
   //   - I/O
   //   - Seeding from a seed_seq.
 };
@@ -177,8 +295,14 @@ class xoshiro_plus : public xoshiro_base {
  public:
   using base::base;
 
+  template <typename V>
+  static inline void output( V const& s0, V const&, V const& s3, V& out ) noexcept {
+    out = static_cast<V>( s0 + s3 );
+  }
+
   typename base::result_type operator()() {
-    const typename base::state_type result = base::s0_ + base::s3_;
+    typename base::state_type result;
+    output( base::s0_, base::s1_, base::s3_, result );
 
     base::advance();
 
@@ -194,8 +318,14 @@ class xoshiro_star : public xoshiro_base {
  public:
   using base::base;
 
+  template <typename V>
+  static inline void output( V const&, V const& s1, V const&, V& out ) noexcept {
+    out = static_cast<V>( s1 * mult );
+  }
+
   typename base::result_type operator()() {
-    const typename base::state_type result_star = base::s1_ * mult;
+    typename base::state_type result_star;
+    output( base::s0_, base::s1_, base::s3_, result_star );
 
     base::advance();
 
@@ -212,8 +342,16 @@ class xoshiro_starstar : public xoshiro_base {
  public:
   using base::base;
 
+  template <typename V>
+  static inline void output( V const&, V const& s1, V const&, V& out ) noexcept {
+    out = static_cast<V>( s1 * mult1 );
+    base::rotl( out, orot );
+    out = static_cast<V>( out * mult2 );
+  }
+
   typename base::result_type operator()() {
-    const typename base::state_type result_ss = base::rotl( base::s1_ * mult1, orot ) * mult2;
+    typename base::state_type result_ss;
+    output( base::s0_, base::s1_, base::s3_, result_ss );
 
     base::advance();
 
@@ -221,8 +359,115 @@ class xoshiro_starstar : public xoshiro_base {
   }
 };
 
+// bulk generation for the `bulk` class below. the lanes of a vector are independent generators
+// and the vector width is picked at compile time ( avx-512, avx2, sse2 / neon or scalar )
+#if defined( __AVX512F__ )
+inline constexpr std::size_t SIMD_BYTES = 64;
+#elif defined( __AVX2__ )
+inline constexpr std::size_t SIMD_BYTES = 32;
+#elif defined( __SSE2__ ) || defined( __ARM_NEON )
+inline constexpr std::size_t SIMD_BYTES = 16;
+#else
+inline constexpr std::size_t SIMD_BYTES = 0;
+#endif
+
+template <typename itype>
+inline constexpr std::size_t native_lanes =
+    SIMD_BYTES >= 2 * sizeof( itype ) ? SIMD_BYTES / sizeof( itype ) : 1;
+
+template <typename T, std::size_t LANES, bool = ( LANES > 1 )>
+struct lanes_of {
+  using type = T;
+};
+
+template <typename T, std::size_t LANES>
+struct lanes_of<T, LANES, true> {
+  typedef T type __attribute__( ( vector_size( LANES * sizeof( T ) ) ) );
+};
+
 } // namespace detail
 
+// runs `LANES` copies of the generator `Gen` side by side in simd registers
+//   - lane `k` starts at the seed generator advanced by `k` calls to `jump()`, i.e. the lanes are
+//     non-overlapping streams
+//   - output is interleaved: value `i` is the `i / LANES`th output of lane `i % LANES`. every lane
+//     is bit-exact to the scalar generator, independent of the vector width and of how the output
+//     is split across `fill()` calls
+template <typename Gen, std::size_t LANES = detail::native_lanes<typename Gen::state_type>>
+class bulk {
+  static_assert( LANES > 0 && ( LANES & ( LANES - 1 ) ) == 0, "LANES must be a power of two" );
+
+ public:
+  using state_type = typename Gen::state_type;
+  using result_type = typename Gen::result_type;
+  using vector_type = typename detail::lanes_of<state_type, LANES>::type;
+
+  static constexpr std::size_t lanes() { return LANES; }
+  static constexpr result_type min() { return Gen::min(); }
+  static constexpr result_type max() { return Gen::max(); }
+
+ private:
+  static constexpr unsigned SHIFT = 8 * ( sizeof( state_type ) - sizeof( result_type ) );
+
+  vector_type _s[Gen::WORDS];
+  state_type _buffer[LANES];
+  std::size_t _next{ LANES };
+
+  inline void generate( state_type* out ) noexcept {
+    vector_type v;
+    Gen::output( _s[0], _s[1], _s[3], v );
+    if constexpr( Gen::WORDS == 4 ) {
+      Gen::step( _s[0], _s[1], _s[2], _s[3] );
+    } else {
+      Gen::step( _s[0], _s[1], _s[2], _s[3], _s[4], _s[5], _s[6], _s[7] );
+    }
+    std::memcpy( out, &v, sizeof( v ) );
+  }
+
+  static inline result_type convert( state_type const x ) noexcept {
+    return static_cast<result_type>( x >> SHIFT );
+  }
+
+ public:
+  explicit bulk( Gen gen = Gen{} ) noexcept {
+    state_type words[Gen::WORDS][LANES];
+    for( std::size_t k = 0; k < LANES; ++k ) {
+      auto const st = gen.state();
+      for( std::size_t w = 0; w < Gen::WORDS; ++w ) words[w][k] = st[w];
+      gen.jump();
+    }
+    for( std::size_t w = 0; w < Gen::WORDS; ++w ) std::memcpy( &_s[w], words[w], sizeof( _s[w] ) );
+  }
+
+  result_type operator()() noexcept {
+    if( _next == LANES ) {
+      generate( _buffer );
+      _next = 0;
+    }
+    return convert( _buffer[_next++] );
+  }
+
+  template <typename It>
+  void fill( It begin, It const end ) noexcept {
+    while( begin != end && _next < LANES ) *begin++ = convert( _buffer[_next++] );
+    using category = typename std::iterator_traits<It>::iterator_category;
+    if constexpr( std::is_base_of_v<std::random_access_iterator_tag, category> ) {
+      if constexpr( SHIFT == 0 && std::is_same_v<It, result_type*> ) {
+        for( ; static_cast<std::size_t>( end - begin ) >= LANES; begin += LANES ) generate( begin );
+      } else {
+        state_type tmp[LANES];
+        while( static_cast<std::size_t>( end - begin ) >= LANES ) {
+          generate( tmp );
+          for( std::size_t k = 0; k < LANES; ++k ) *begin++ = convert( tmp[k] );
+        }
+      }
+    }
+    while( begin != end ) *begin++ = ( *this )();
+  }
+
+  void fill( result_type* const data, std::size_t const n ) noexcept { fill( data, data + n ); }
+};
+
 // - 512 state bits, uint64_t output, period 2^512 - 1
 
 using xoshiro512plus64v1_0 = detail::xoshiro_plus<detail::xoshiro_x8<uint64_t, uint64_t, 11, 21>>;
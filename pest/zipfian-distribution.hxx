@@ -23,9 +23,10 @@ usage example:
     return i;
   }
 
-IMPORTANT: constructing the distribution object requires calculating the zeta value which becomes
-prohibetively expensive for very large ranges. As an alternative for such cases, the user can pass
-the pre-calculated values and avoid the calculation every time.
+constructing the distribution object requires calculating the zeta value. the first 1024 terms are
+summed up, the tail is approximated in O(1) ( euler-maclaurin ), i.e. construction is cheap even
+for huge ranges. the constants needed for sampling are precomputed in `param_type`. if zeta is
+known already it can still be passed explicitly:
 
 usage example:
 
@@ -39,12 +40,20 @@ usage example:
     int i = distribution(generator);
     return i;
   }
+
+`scrambled_zipfian_int_distribution` permutes the values so the popular ones are spread over the
+whole range instead of clustering at `a`.
 */
 
+#pragma once
+
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 #include <random>
+#include <type_traits>
 
 namespace emptyspace {
 
@@ -61,21 +70,18 @@ class zipfian_int_distribution {
 
     explicit param_type( _IntType __a = 0, _IntType __b = std::numeric_limits<_IntType>::max(),
                          double __theta = 0.99 )
-      : _M_a( __a ),
-        _M_b( __b ),
-        _M_theta( __theta ),
-        _M_zeta( zeta( _M_b - _M_a + 1, __theta ) ),
-        _M_zeta2theta( zeta( 2, __theta ) ) {
-      assert( _M_a <= _M_b && _M_theta > 0.0 && _M_theta < 1.0 );
-    }
+      : param_type( __a, __b, __theta, zeta( range( __a, __b ), __theta ) ) {}
 
     explicit param_type( _IntType __a, _IntType __b, double __theta, double __zeta )
       : _M_a( __a ),
         _M_b( __b ),
         _M_theta( __theta ),
         _M_zeta( __zeta ),
-        _M_zeta2theta( zeta( 2, __theta ) ) {
-      __glibcxx_assert( _M_a <= _M_b && _M_theta > 0.0 && _M_theta < 1.0 );
+        _M_zeta2theta( 1.0 + std::pow( 0.5, __theta ) ),
+        _M_n( static_cast<double>( range( __a, __b ) ) ),
+        _M_alpha( 1.0 / ( 1.0 - __theta ) ),
+        _M_eta( ( 1.0 - std::pow( 2.0 / _M_n, 1.0 - __theta ) ) / ( 1.0 - _M_zeta2theta / __zeta ) ) {
+      assert( _M_a <= _M_b && _M_theta > 0.0 && _M_theta < 1.0 );
     }
 
     result_type a() const { return _M_a; }
@@ -88,27 +94,85 @@ class zipfian_int_distribution {
 
     double zeta2theta() const { return _M_zeta2theta; }
 
+    double alpha() const { return _M_alpha; }
+
+    double eta() const { return _M_eta; }
+
+    double n() const { return _M_n; }
+
     friend bool operator==( const param_type& __p1, const param_type& __p2 ) {
       return __p1._M_a == __p2._M_a && __p1._M_b == __p2._M_b && __p1._M_theta == __p2._M_theta &&
           __p1._M_zeta == __p2._M_zeta && __p1._M_zeta2theta == __p2._M_zeta2theta;
     }
 
+    /**
+     * @brief Calculates zeta( n, theta ) = sum( 1 / i^theta ) for i in [1, n].
+     *
+     * The first `_S_exact` terms are summed up, the remaining tail is approximated in O(1) using
+     * the Euler-Maclaurin formula.
+     *
+     * @param __n [IN]  The size of the domain.
+     * @param __theta [IN]  The skew factor of the distribution.
+     */
+    static double zeta( unsigned long long __n, double __theta ) {
+      auto const __m = std::min( __n, _S_exact );
+      return zeta( __m, __n, __theta, zeta_exact( 0, __m, __theta ) );
+    }
+
+    /**
+     * @brief Calculates zeta( n, theta ) from a known zeta( m, theta ).
+     *
+     * Useful if the range grows, e.g. for workloads inserting new keys.
+     *
+     * @param __m [IN]  The size of the domain `__zeta_m` was calculated for.
+     * @param __n [IN]  The new size of the domain ( `__n >= __m` ).
+     * @param __theta [IN]  The skew factor of the distribution.
+     * @param __zeta_m [IN]  zeta( m, theta ).
+     */
+    static double zeta( unsigned long long __m, unsigned long long __n, double __theta,
+                        double __zeta_m ) {
+      assert( __m <= __n );
+      if( __n - __m <= _S_exact || __m == 0 ) { return __zeta_m + zeta_exact( __m, __n, __theta ); }
+      // sum( f(i) ) for i in [m + 1, n] with f(x) = x^-theta is approximated by
+      //   integral( f, m, n ) + ( f(n) - f(m) ) / 2 + ( f'(n) - f'(m) ) / 12
+      //     - ( f'''(n) - f'''(m) ) / 720
+      auto const m = static_cast<double>( __m );
+      auto const n = static_cast<double>( __n );
+      auto const f = [__theta]( double const x ) { return std::pow( x, -__theta ); };
+      auto const f1 = [__theta]( double const x ) { return -__theta * std::pow( x, -__theta - 1.0 ); };
+      auto const f3 = [__theta]( double const x ) {
+        return -__theta * ( __theta + 1.0 ) * ( __theta + 2.0 ) * std::pow( x, -__theta - 3.0 );
+      };
+      auto const integral =
+          ( std::pow( n, 1.0 - __theta ) - std::pow( m, 1.0 - __theta ) ) / ( 1.0 - __theta );
+      return __zeta_m + integral + ( f( n ) - f( m ) ) * 0.5 + ( f1( n ) - f1( m ) ) / 12.0 -
+          ( f3( n ) - f3( m ) ) / 720.0;
+    }
+
    private:
     _IntType _M_a;
     _IntType _M_b;
     double _M_theta;
     double _M_zeta;
     double _M_zeta2theta;
+    // derived constants, calculated once instead of for every sample
+    double _M_n;
+    double _M_alpha;
+    double _M_eta;
+
+    static constexpr unsigned long long _S_exact = 1024;
+
+    // saturates for the full 64 bit range
+    static unsigned long long range( _IntType __a, _IntType __b ) {
+      auto const __n =
+          static_cast<unsigned long long>( __b ) - static_cast<unsigned long long>( __a ) + 1;
+      return __n == 0 ? std::numeric_limits<unsigned long long>::max() : __n;
+    }
 
-    /**
-     * @brief Calculates zeta.
-     *
-     * @param __n [IN]  The size of the domain.
-     * @param __theta [IN]  The skew factor of the distribution.
-     */
-    double zeta( unsigned long __n, double __theta ) {
+    // sum( 1 / i^theta ) for i in [m + 1, n]
+    static double zeta_exact( unsigned long long __m, unsigned long long __n, double __theta ) {
       double ans = 0.0;
-      for( unsigned long i = 1; i <= __n; ++i )
+      for( unsigned long long i = __m + 1; i <= __n; ++i )
         ans += std::pow( 1.0 / static_cast<double>( i ), __theta );
       return ans;
     }
@@ -172,19 +236,29 @@ class zipfian_int_distribution {
 
   template <typename _UniformRandomNumberGenerator>
   result_type operator()( _UniformRandomNumberGenerator& __urng, const param_type& __p ) {
-    double alpha = 1 / ( 1 - __p.theta() );
-    double eta = ( 1 - std::pow( 2.0 / ( __p.b() - __p.a() + 1 ), 1 - __p.theta() ) ) /
-        ( 1 - __p.zeta2theta() / __p.zeta() );
-
     double u = std::generate_canonical<double, std::numeric_limits<double>::digits,
                                        _UniformRandomNumberGenerator>( __urng );
 
     double uz = u * __p.zeta();
     if( uz < 1.0 ) return __p.a();
-    if( uz < 1.0 + std::pow( 0.5, __p.theta() ) ) return __p.a() + 1;
+    if( uz < __p.zeta2theta() ) return __p.a() + 1;
 
-    return static_cast<result_type>(
-        __p.a() + ( ( __p.b() - __p.a() + 1 ) * std::pow( eta * u - eta + 1, alpha ) ) );
+    auto const rank = __p.n() * std::pow( __p.eta() * u - __p.eta() + 1, __p.alpha() );
+    return static_cast<result_type>( __p.a() + static_cast<result_type>( rank ) );
+  }
+
+  /**
+   * @brief Fills [__f, __t) with samples of the distribution.
+   */
+  template <typename _ForwardIterator, typename _UniformRandomNumberGenerator>
+  void generate( _ForwardIterator __f, _ForwardIterator __t, _UniformRandomNumberGenerator& __urng ) {
+    this->generate( __f, __t, __urng, _M_param );
+  }
+
+  template <typename _ForwardIterator, typename _UniformRandomNumberGenerator>
+  void generate( _ForwardIterator __f, _ForwardIterator __t, _UniformRandomNumberGenerator& __urng,
+                 const param_type& __p ) {
+    for( ; __f != __t; ++__f ) *__f = this->operator()( __urng, __p );
   }
 
   /**
@@ -199,4 +273,87 @@ class zipfian_int_distribution {
   param_type _M_param;
 };
 
+/**
+ * @brief A zipfian distribution with the popular values scattered over [a, b].
+ *
+ * A rank is drawn from zipfian_int_distribution over [0, b - a] and mapped to a value using a
+ * seeded bijection on [0, b - a] ( multiply / xorshift rounds on the next power of two with cycle
+ * walking ). Every value is exactly as popular as with the plain distribution, only the hot values
+ * no longer cluster at the low end of the range.
+ */
+template <typename _IntType = int>
+class scrambled_zipfian_int_distribution {
+  static_assert( std::is_integral<_IntType>::value, "Template argument not an integral type." );
+
+ public:
+  /** The type of the range of the distribution. */
+  typedef _IntType result_type;
+
+  explicit scrambled_zipfian_int_distribution( _IntType __a = _IntType( 0 ),
+                                               _IntType __b = _IntType( 1 ), double __theta = 0.99,
+                                               std::uint64_t __seed = 0 )
+    : _M_a( __a ),
+      _M_b( __b ),
+      _M_last( static_cast<std::uint64_t>( __b ) - static_cast<std::uint64_t>( __a ) ),
+      _M_rank( 0, _M_last, __theta ) {
+    auto const __bits = _M_last == 0 ? 0u : 64u - static_cast<unsigned>( __builtin_clzll( _M_last ) );
+    _M_mask = __bits == 64 ? ~std::uint64_t( 0 ) : ( std::uint64_t( 1 ) << __bits ) - 1;
+    _M_shift = __bits / 2 + 1;
+    _M_seed = __seed & _M_mask;
+  }
+
+  void reset() {}
+
+  result_type a() const { return _M_a; }
+
+  result_type b() const { return _M_b; }
+
+  double theta() const { return _M_rank.theta(); }
+
+  result_type min() const { return this->a(); }
+
+  result_type max() const { return this->b(); }
+
+  /**
+   * @brief Maps a rank in [0, b - a] to its value in [a, b].
+   */
+  result_type scramble( std::uint64_t __rank ) const {
+    assert( __rank <= _M_last );
+    do { __rank = mix( __rank ); } while( __rank > _M_last );
+    return static_cast<result_type>( static_cast<std::uint64_t>( _M_a ) + __rank );
+  }
+
+  template <typename _UniformRandomNumberGenerator>
+  result_type operator()( _UniformRandomNumberGenerator& __urng ) {
+    return scramble( _M_rank( __urng ) );
+  }
+
+  /**
+   * @brief Fills [__f, __t) with samples of the distribution.
+   */
+  template <typename _ForwardIterator, typename _UniformRandomNumberGenerator>
+  void generate( _ForwardIterator __f, _ForwardIterator __t, _UniformRandomNumberGenerator& __urng ) {
+    for( ; __f != __t; ++__f ) *__f = this->operator()( __urng );
+  }
+
+ private:
+  _IntType _M_a;
+  _IntType _M_b;
+  std::uint64_t _M_last;
+  zipfian_int_distribution<std::uint64_t> _M_rank;
+  std::uint64_t _M_mask;
+  unsigned _M_shift;
+  std::uint64_t _M_seed;
+
+  // bijection on [0, _M_mask]
+  std::uint64_t mix( std::uint64_t __x ) const {
+    __x ^= _M_seed;
+    __x = ( __x * 0x9e3779b97f4a7c15ull ) & _M_mask;
+    __x ^= __x >> _M_shift;
+    __x = ( __x * 0xbf58476d1ce4e5b9ull ) & _M_mask;
+    __x ^= __x >> _M_shift;
+    return __x;
+  }
+};
+
 } // namespace emptyspace
@@ -1,12 +1,18 @@
 // SPDX-License-Identifier: BlueOak-1.0.0
 
+#include <pest/alloc-hook.hxx>
 #include <pest/bitmask-distribution.hxx>
+#include <pest/lemire-distribution.hxx>
 #include <pest/pest.hxx>
 #include <pest/pnch.hxx>
+#include <pest/workload.hxx>
 #include <pest/xoshiro.hxx>
+#include <pest/zipfian-distribution.hxx>
 
+#include <atomic>
 #include <exception>
 #include <map>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <vector>
@@ -56,11 +62,125 @@ emptyspace::pest::suite basic( "pest test suite", []( auto& test ) {
     expect( throws<std::out_of_range>( [&]() { throw std::out_of_range( "" ); } ) );
   } );
 
+  test( "no allocations and at most n bytes in scope", []( auto& expect ) {
+    expect( emptyspace::alloc::hooked() );
+    std::vector<int> v( 64 );
+    {
+      auto const scope = expect.no_allocations();
+      for( auto& x : v ) x += 1;
+    }
+    {
+      auto const scope = expect.at_most_bytes( 64 * sizeof( int ) );
+      std::vector<int> const w( 64 );
+      emptyspace::pnch::doNotOptimizeAway( w.data() );
+    }
+    std::ostringstream os;
+    test_state nested{ os };
+    {
+      auto const scope = nested.no_allocations();
+      v.resize( 128 );
+      emptyspace::pnch::doNotOptimizeAway( v.data() );
+    }
+    expect( nested._failed, equal_to( 1u ) );
+    expect( os.str().find( "assertion = no_allocations" ), not_equal_to( std::string::npos ) );
+  } );
+
   test( "xoshiro with boring seed", []( auto& expect ) {
     xoshiro128starstar32 xo{ 0x2342 };
     expect( xo(), equal_to( 1566649558u ) );
   } );
 
+  // expected states are independent of the jump polynomials: the seed state multiplied by the
+  // step function's gf(2) matrix raised to 2^128 / 2^192 ( 256 ), 2^64 / 2^96 ( 128 ) and
+  // 2^256 ( 512 )
+  test( "xoshiro jump and long_jump known answers", []( auto& expect ) {
+    xoshiro256starstar64 j256{ 0x2323 };
+    auto l256 = j256;
+    j256.jump();
+    l256.long_jump();
+    expect( j256.state(), equal_to( { 0x18bda3cf480dd6deu, 0x67f776cba7ebb601u, 0x1232602d33d8f9a5u,
+                                      0xc4f361c7930d70a0u } ) );
+    expect( j256(), equal_to( 0x3ff0e642377f169bu ) );
+    expect( l256.state(), equal_to( { 0x159a6c76e3194597u, 0x333045fab3ee83b0u, 0xa6006ebec426f611u,
+                                      0x1b07e355bdacc76eu } ) );
+    expect( l256(), equal_to( 0xbe2688d07692fc77u ) );
+
+    xoshiro128starstar32 j128{ 0x2323 };
+    auto l128 = j128;
+    j128.jump();
+    l128.long_jump();
+    expect( j128.state(), equal_to( { 0xa551da5bu, 0x578d616du, 0x9fe65579u, 0xd36bb2dau } ) );
+    expect( j128(), equal_to( 0xed1017aau ) );
+    expect( l128.state(), equal_to( { 0x85af7060u, 0xc4a0c733u, 0xf69d92fdu, 0x5e23175cu } ) );
+    expect( l128(), equal_to( 0x2181ff43u ) );
+
+    xoshiro512starstar64 j512{ 0x2323 };
+    j512.jump();
+    expect( j512.state(), equal_to( { 0xf8425ceb610a8397u, 0x400e504399d28567u, 0x20dc0f65b39c4385u,
+                                      0xdda43824cd36c68du, 0xdb220085992833c8u, 0x3ade2c31feb0e55bu,
+                                      0x027e0deeb5fd2745u, 0xd43288a72375f86eu } ) );
+    expect( j512(), equal_to( 0x420df10500b98ea0u ) );
+  } );
+
+  test( "xoshiro jump yields the lanes of bulk", []( auto& expect ) {
+    // lane `k` of `bulk<Gen, LANES>` is `Gen` jumped `k` times, output interleaved
+    auto const lanes_match = [&]( auto rng, auto& b ) {
+      using result_type = typename decltype( rng )::result_type;
+      auto const n = b.lanes();
+      std::vector<result_type> vs( 42 );
+      b.fill( vs.data(), 5 );
+      b.fill( vs.begin() + 5, vs.end() );
+      std::vector<decltype( rng )> lanes;
+      for( std::size_t k = 0; k < n; ++k ) {
+        lanes.push_back( rng );
+        rng.jump();
+      }
+      for( std::size_t i = 0; i < vs.size(); ++i ) expect( vs[i], equal_to( lanes[i % n]() ) );
+    };
+    xoshiro256starstar64 const starstar{ 0x2342 };
+    bulk<xoshiro256starstar64, 4> four{ starstar };
+    lanes_match( starstar, four );
+    bulk<xoshiro256starstar64> native{ starstar };
+    lanes_match( starstar, native );
+    xoshiro256plus64 const plus{ 0x2342 };
+    bulk<xoshiro256plus64> plus_native{ plus };
+    lanes_match( plus, plus_native );
+    xoshiro512starstar64 const x8{ 0x2342 };
+    bulk<xoshiro512starstar64> x8_native{ x8 };
+    lanes_match( x8, x8_native );
+    xoshiro128starstar32 const narrow{ 0x2342 };
+    bulk<xoshiro128starstar32> narrow_native{ narrow };
+    lanes_match( narrow, narrow_native );
+  } );
+
+  test( "suite with parallel runner, filter and shards", []( auto& expect ) {
+    suite inner( "inner", []( auto& test ) {
+      for( auto const* name : { "a/1", "a/2", "a/3", "b/1", "a/4" } ) {
+        test( name, [name]( auto& expect ) {
+          expect( std::string_view{ name }.size(), equal_to( 3u ) );
+        } );
+      }
+    } );
+    std::ostringstream os;
+    options opts;
+    opts._jobs = 4;
+    opts._filter = "a/*";
+    inner( os, opts );
+    auto const out = os.str();
+    auto const a1 = out.find( "| a/1]" );
+    auto const a4 = out.find( "| a/4]" );
+    expect( a1 != std::string::npos && a4 != std::string::npos && a1 < a4 );
+    expect( out.find( "| b/1]" ), equal_to( std::string::npos ) );
+    expect( out.find( "total tests = 4" ) != std::string::npos );
+    char const* argv[] = { "driver", "--shard", "1/2", "--jobs", "2" };
+    auto const sharded = options::from_args( 5, argv );
+    expect( sharded._shard, equal_to( 1u ) );
+    expect( sharded._shards, equal_to( 2u ) );
+    std::ostringstream os2;
+    inner( os2, sharded );
+    expect( os2.str().find( "total tests = 2" ) != std::string::npos );
+  } );
+
   test( "benchmark nothing", []( auto& expect ) {
     emptyspace::pnch::config cfg;
     int x = 0;
@@ -69,6 +189,121 @@ emptyspace::pest::suite basic( "pest test suite", []( auto& test ) {
     expect( x, equal_to( 2 * 3 ) );
   } );
 
+  test( "benchmark nothing without hardware counters", []( auto& expect ) {
+    emptyspace::pnch::config cfg;
+    int x = 0;
+    std::ostringstream os;
+    cfg.counters( false ).i( 2 ).o( 3 ).run( "nothings", [&]() { x += 1; } ).report_to( os );
+    expect( x, equal_to( 2 * 3 ) );
+    expect( os.str().find( "hwc/" ), equal_to( std::string::npos ) );
+  } );
+
+  test( "benchmark nothing calibrated", []( auto& expect ) {
+    using namespace std::chrono_literals;
+    emptyspace::pnch::config cfg;
+    int x = 0;
+    std::ostringstream os;
+    cfg.warmup( 1ms ).target( 100us ).budget( 10ms );
+    cfg.calibrate( "nothings", [&]() { x += 1; } ).touch( x ).report_to( os );
+    expect( cfg.stats().count() >= 5u );
+    expect( cfg._inner_loop_cnt > 0u );
+    expect( cfg._offset >= .0 );
+  } );
+
+  test( "benchmark calibrated target out of budget", []( auto& expect ) {
+    using namespace std::chrono_literals;
+    emptyspace::pnch::config cfg;
+    std::ostringstream os;
+    cfg.warmup( 1ms ).target( 10s ).budget( 10ms );
+    cfg.calibrate( "empty", []() {} ).report_to( os );
+    expect( cfg._target_reached, equal_to( false ) );
+    expect( cfg._inner_loop_cnt > 0u );
+    expect( os.str().find( "stats/error = target not reached" ), not_equal_to( std::string::npos ) );
+  } );
+
+  test( "benchmark scaling sweep", []( auto& expect ) {
+    emptyspace::pnch::scaling sc;
+    std::atomic<int> x{ 0 };
+    std::ostringstream os;
+    sc.i( 2 ).o( 3 ).sweep( "atomic increment", [&]() { x++; }, 3 ).report_to( os );
+    expect( sc.size(), equal_to( 3u ) );
+    expect( sc.threads( 2 ), equal_to( 3u ) );
+    expect( x.load(), equal_to( ( 1 + 2 + 3 ) * 2 * 3 ) );
+    expect( sc.stats( 2, 1 ).count(), equal_to( 3u ) );
+  } );
+
+  test( "benchmark scaling sweep limited to the placement cpus", []( auto& expect ) {
+    emptyspace::pnch::scaling sc;
+    std::atomic<int> x{ 0 };
+    std::ostringstream os;
+    sc.cpus( { 0 } ).i( 2 ).o( 3 ).sweep( "atomic increment", [&]() { x++; } );
+    expect( sc.size(), equal_to( 1u ) );
+    expect( sc.threads( 0 ), equal_to( 1u ) );
+    sc.run( "atomic increment", 2, [&]() { x++; } ).report_to( os );
+    expect( os.str().find( "threads/2/oversubscribed = 2 threads on 1 cpus" ),
+            not_equal_to( std::string::npos ) );
+  } );
+
+  test( "numa cpulists", []( auto& expect ) {
+    using emptyspace::pnch::detail::parse_cpulist;
+    expect( parse_cpulist( "0-3,8,10-11\n" ), equal_to( { 0, 1, 2, 3, 8, 10, 11 } ) );
+    expect( parse_cpulist( "\n" ).empty() );
+    expect( parse_cpulist( "" ).empty() );
+    auto const allowed = emptyspace::pnch::detail::allowed_cpus();
+    for( auto const& node : emptyspace::pnch::detail::numa_nodes() ) {
+      for( auto const cpu : node ) {
+        expect( std::binary_search( allowed.begin(), allowed.end(), cpu ) );
+      }
+    }
+  } );
+
+  test( "histogram percentiles and merge", []( auto& expect ) {
+    emptyspace::pnch::histogram h1;
+    emptyspace::pnch::histogram h2;
+    for( std::uint64_t v = 1; v <= 16; ++v ) h1.record( v );
+    for( std::uint64_t v = 17; v <= 32; ++v ) h2.record( v );
+    h1.merge( h2 );
+    expect( h1.count(), equal_to( 32u ) );
+    expect( h1.min(), equal_to( 1u ) );
+    expect( h1.max(), equal_to( 32u ) );
+    expect( h1.percentile( 50.0 ), equal_to( 16u ) );
+    expect( h1.percentile( 100.0 ), equal_to( 32u ) );
+    h1.record( 1'000'000 );
+    auto const p = h1.percentile( 100.0 );
+    expect( p >= 1'000'000u && p <= 1'000'000u + 1'000'000u / 32u );
+  } );
+
+  test( "benchmark latency nothing", []( auto& expect ) {
+    emptyspace::pnch::latency lat;
+    int x = 0;
+    std::ostringstream os;
+    lat.n( 1000 ).run( "nothings", [&]() { x += 1; } ).touch( x ).report_to( os );
+    expect( x, equal_to( 1000 ) );
+    expect( lat.hist().count(), equal_to( 1000u ) );
+  } );
+
+  test( "benchmark json round trip and baseline comparison", []( auto& expect ) {
+    emptyspace::pnch::config cfg;
+    int x = 0;
+    std::ostringstream os;
+    cfg.i( 2 ).o( 8 ).run( "nothings", [&]() { x += 1; } ).touch( x ).json_to( os );
+    std::istringstream is{ os.str() };
+    emptyspace::pnch::baseline base{ is };
+    expect( base.size(), equal_to( 1u ) );
+    expect( base.contains( "nothings" ) );
+    auto const same = base.compare( cfg );
+    expect( same._known );
+    expect( same._regression, equal_to( false ) );
+    auto const slower = std::vector<double>( 8, 1'000'000.0 );
+    expect( base.compare( "nothings", slower )._regression );
+    expect( base.compare( "unknown", slower )._known, equal_to( false ) );
+    std::istringstream malformed{
+        os.str() + R"({"kind":"benchmark","name":"bad\uzz","inner":1,"results":[1]})" "\n" };
+    emptyspace::pnch::baseline partial{ malformed };
+    expect( partial.size(), equal_to( 1u ) );
+    expect( partial.contains( "nothings" ) );
+  } );
+
   test( "benchmark oneshot nothing", []( auto& expect ) {
     int x = 0;
     emptyspace::pnch::oneshot cfg;
@@ -77,6 +312,22 @@ emptyspace::pest::suite basic( "pest test suite", []( auto& test ) {
     expect( x, equal_to( 1 ) );
   } );
 
+  test( "benchmark allocations per iteration", []( auto& expect ) {
+    emptyspace::pnch::config cfg;
+    std::ostringstream os;
+    // the pointer has to escape, otherwise the new / delete pair may be elided ( [expr.new] )
+    auto const allocate = []() {
+      auto* const p = new int{ 42 };
+      emptyspace::pnch::doNotOptimizeAway( p );
+      delete p;
+    };
+    cfg.i( 10 ).o( 3 ).run( "allocate", allocate ).report_to( os );
+    expect( cfg._allocs._total._allocs, equal_to( 30u ) );
+    expect( cfg._allocs._total._frees, equal_to( 30u ) );
+    expect( cfg._allocs._total._bytes, equal_to( 30u * sizeof( int ) ) );
+    expect( os.str().find( "alloc/allocs = 1" ), not_equal_to( std::string::npos ) );
+  } );
+
   test( "hexify(std::array<std::byte,N>)", []( auto& expect ) {
     std::array<std::byte, 2> bytes{ std::byte( 0x23 ), std::byte( 0x42 ) };
     expect( hexify( bytes ), equal_to( "2342" ) );
@@ -87,6 +338,106 @@ emptyspace::pest::suite basic( "pest test suite", []( auto& test ) {
     expect( hexify( bytes ), equal_to( "2342" ) );
   } );
 
+  test( "zipfian_int_distribution approximated zeta", []( auto& expect ) {
+    using param_type = emptyspace::zipfian_int_distribution<long>::param_type;
+    double exact = 0.0;
+    for( auto i = 1; i <= 100'000; ++i ) exact += std::pow( 1.0 / i, 0.99 );
+    auto const approx = param_type::zeta( 100'000, 0.99 );
+    expect( std::abs( approx - exact ) / exact < 1e-12 );
+    auto const grown = param_type::zeta( 50'000, 100'000, 0.99, param_type::zeta( 50'000, 0.99 ) );
+    expect( std::abs( grown - exact ) / exact < 1e-12 );
+  } );
+
+  test( "zipfian_int_distribution<long>{ 1, 1e9 } generate", []( auto& expect ) {
+    xoshiro256starstar64 rng{ 0x2323 };
+    emptyspace::zipfian_int_distribution<long> gen{ 1, 1'000'000'000, 0.99 };
+    std::vector<long> xs( 42 );
+    gen.generate( xs.begin(), xs.end(), rng );
+    for( auto const x : xs ) expect( x >= 1 && x <= 1'000'000'000 );
+  } );
+
+  test( "scrambled_zipfian_int_distribution<int>{ -5, 994 } is a permutation", []( auto& expect ) {
+    emptyspace::scrambled_zipfian_int_distribution<int> gen{ -5, 994, 0.99, 0x2342 };
+    std::set<int> xs;
+    for( std::uint64_t rank = 0; rank < 1000; ++rank ) xs.insert( gen.scramble( rank ) );
+    expect( xs.size(), equal_to( 1000u ) );
+    expect( *xs.begin(), equal_to( -5 ) );
+    expect( *xs.rbegin(), equal_to( 994 ) );
+    expect( gen.scramble( 0 ), not_equal_to( -5 ) );
+  } );
+
+  test( "lemire_distribution<int>{ -3, 3 }", []( auto& expect ) {
+    xoshiro256starstar64 rng{ 0x2323 };
+    emptyspace::lemire_distribution<int> gen{ -3, 3 };
+    std::map<int, int> counts;
+    for( auto i = 0; i < 7'000; ++i ) counts[gen( rng )] += 1;
+    expect( counts.size(), equal_to( 7u ) );
+    expect( counts.begin()->first, equal_to( -3 ) );
+    expect( counts.rbegin()->first, equal_to( 3 ) );
+    for( auto const& [x, n] : counts ) expect( n > 800 && n < 1'200 );
+    emptyspace::lemire_distribution<int> single{ 5, 5 };
+    expect( single( rng ), equal_to( 5 ) );
+  } );
+
+  test( "workload::stream ycsb d", []( auto& expect ) {
+    using namespace emptyspace::workload;
+    auto s = spec::d();
+    s._records = 1'000;
+    s._operations = 200'000;
+    auto const one = stream::generate( s, 1 );
+    auto const four = stream::generate( s, 4 );
+    expect( std::equal( one.keys(), one.keys() + one.size(), four.keys() ) );
+    expect( std::equal( one.ops(), one.ops() + one.size(), four.ops() ) );
+    std::uint64_t next = s._records;
+    auto inserts = 0;
+    for( std::size_t i = 0; i < one.size(); ++i ) {
+      auto const [key, o] = one[i];
+      if( o == op::insert ) {
+        expect( key, equal_to( next++ ) );
+        ++inserts;
+      } else {
+        expect( o == op::read && key < next );
+      }
+    }
+    expect( inserts > 9'000 && inserts < 11'000 );
+  } );
+
+  test( "workload::stream hotspot with all or no hot requests", []( auto& expect ) {
+    using namespace emptyspace::workload;
+    auto s = spec::c();
+    s._records = 100;
+    s._operations = 1'000;
+    s._hot_set = 0.1;
+    s._distribution = distribution::hotspot;
+    s._hot_ops = 1.0;
+    auto const all = stream::generate( s, 2 );
+    expect(
+        std::all_of( all.keys(), all.keys() + all.size(), []( auto const k ) { return k < 10u; } ) );
+    s._hot_ops = 0.0;
+    auto const none = stream::generate( s, 2 );
+    expect( std::all_of( none.keys(), none.keys() + none.size(),
+                         []( auto const k ) { return k >= 10u && k < 100u; } ) );
+  } );
+
+  test( "workload::stream single value key ranges", []( auto& expect ) {
+    using namespace emptyspace::workload;
+    auto hotspot = spec::c();
+    hotspot._records = 10;
+    hotspot._operations = 1'000;
+    hotspot._hot_set = 0.9;
+    hotspot._distribution = distribution::hotspot;
+    auto const hs = stream::generate( hotspot, 2 );
+    expect( std::all_of( hs.keys(), hs.keys() + hs.size(), []( auto const k ) { return k < 10u; } ) );
+    expect( std::count( hs.keys(), hs.keys() + hs.size(), 9u ) > 0 );
+
+    auto uniform = spec::c();
+    uniform._records = 1;
+    uniform._operations = 1'000;
+    uniform._distribution = distribution::uniform;
+    auto const us = stream::generate( uniform, 2 );
+    expect( std::all_of( us.keys(), us.keys() + us.size(), []( auto const k ) { return k == 0u; } ) );
+  } );
+
   test( "bitmask_distribution<int>{ 0, 23 }", []( auto& expect ) {
     constexpr auto SHOTS = 42;
     constexpr auto LO = 0;
@@ -129,7 +480,7 @@ emptyspace::pest::suite basic( "pest test suite", []( auto& test ) {
 
 } // namespace
 
-int main() {
-  basic( std::clog );
+int main( int argc, char** argv ) {
+  basic( std::clog, emptyspace::pest::options::from_args( argc, argv ) );
   return 0;
 }